@@ -0,0 +1,182 @@
+// Micro-benchmarks of the building blocks of the solver, on some of the
+// public instances and on generated graphs. Usage:
+//   ./benchmark [--filter SUBSTRING] [--min-time SECONDS] [--json FILE]
+//               [--commit HASH]
+// `make bench` writes the JSON to timings/, named after the commit.
+#include <algorithm>
+#include <climits>
+#include <fstream>
+#include <random>
+#include <set>
+
+#include "benchmark.hpp"
+#include "exact_cache.hpp"
+#include "graph.hpp"
+#include "separator.hpp"
+#include "set_trie.hpp"
+#include "treedepth_tree.hpp"
+
+std::mt19937 rng(42);
+
+// A connected graph on N vertices: a random tree plus M - N + 1 random edges.
+Graph RandomGraph(int N, int M) {
+  std::set<std::pair<int, int>> edges;
+  for (int v = 1; v < N; v++) edges.emplace(rng() % v, v);
+  while (edges.size() < M) {
+    int a = rng() % N, b = rng() % N;
+    if (a < b) edges.emplace(a, b);
+  }
+  return Graph(N, {edges.begin(), edges.end()});
+}
+
+Graph GridGraph(int rows, int columns) {
+  std::vector<std::pair<int, int>> edges;
+  for (int r = 0; r < rows; r++)
+    for (int c = 0; c < columns; c++) {
+      int v = r * columns + c;
+      if (c + 1 < columns) edges.emplace_back(v, v + 1);
+      if (r + 1 < rows) edges.emplace_back(v, v + columns);
+    }
+  return Graph(rows * columns, edges);
+}
+
+// Sorted sets of global vertices, like the keys of the cache: from (at most
+// 1000) vertices the first vertices of a BFS, at most 100 of them.
+std::vector<std::vector<int>> BfsWords(const Graph &G) {
+  std::vector<std::vector<int>> words;
+  for (int i = 0; i < std::min(G.N, 1000); i++) {
+    auto order = G.Bfs(rng() % G.N);
+    order.resize(1 + rng() % std::min<int>(order.size(), 100));
+    std::vector<int> word;
+    for (int w : order) word.push_back(G.global[w]);
+    std::sort(word.begin(), word.end());
+    words.push_back(std::move(word));
+  }
+  return words;
+}
+
+void GraphBenchmarks(BenchmarkRunner &runner, const std::string &name,
+                     Graph graph) {
+  LoadGraph(std::move(graph));
+  const Graph &G = full_graph;
+
+  // The first half of a BFS order induces a connected subgraph.
+  std::vector<int> half = G.Bfs(0);
+  half.resize(std::max(1, G.N / 2));
+  runner.Run("Graph(G, sub_vertices)/" + name, [&] {
+    auto sub_vertices = half;
+    DoNotOptimize(Graph(G, sub_vertices));
+  });
+
+  int v_max_degree = 0;
+  for (int v = 0; v < G.N; v++)
+    if (G.Adj(v).size() == G.max_degree) v_max_degree = v;
+  runner.Run("WithoutVertex/" + name,
+             [&] { DoNotOptimize(G.WithoutVertex(v_max_degree)); });
+
+  // The neighbourhood of a vertex separates it from the rest.
+  const std::vector<int> &separator = G.Adj(v_max_degree);
+  runner.Run("WithoutVertices/" + name,
+             [&] { DoNotOptimize(G.WithoutVertices(separator)); });
+
+  runner.Run("CoreNumbers/" + name, [&] { DoNotOptimize(G.CoreNumbers()); });
+  auto core_numbers = G.CoreNumbers();
+  int degeneracy = *std::max_element(core_numbers.begin(), core_numbers.end());
+  runner.Run("kCore/" + name, [&] { DoNotOptimize(G.kCore(degeneracy)); });
+
+  runner.Run("DfsTree/" + name, [&] { DoNotOptimize(G.DfsTree(0)); });
+  Graph tree = G.DfsTree(0);
+  runner.Run("treedepth_tree/" + name,
+             [&] { DoNotOptimize(treedepth_tree(tree)); });
+
+  // Next consumes the generator, so this includes its construction (which
+  // enqueues the separators around every vertex).
+  size_t num_separators = SeparatorGenerator(G).Next(1000).size();
+  runner.Run(
+      "SeparatorGenerator+Next(1000)/" + name,
+      [&] {
+        SeparatorGenerator generator(G);
+        DoNotOptimize(generator.Next(1000));
+      },
+      num_separators);
+
+  auto words = BfsWords(G);
+  runner.Run(
+      "SetTrie::Insert/" + name,
+      [&] {
+        SetTrie trie;
+        for (auto &word : words) DoNotOptimize(trie.Insert(word));
+      },
+      words.size());
+  SetTrie trie;
+  for (auto &word : words) trie.Insert(word);
+  runner.Run(
+      "SetTrie::Search/" + name,
+      [&] {
+        for (auto &word : words) DoNotOptimize(trie.Search(word));
+      },
+      words.size());
+  runner.Run(
+      "SetTrie::BigSubsets/" + name,
+      [&] {
+        for (auto &word : words) DoNotOptimize(trie.BigSubsets(word, INT_MAX));
+      },
+      words.size());
+}
+
+int main(int argc, char **argv) {
+  BenchmarkRunner runner;
+  std::string json_fn, commit;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--filter" && i + 1 < argc) {
+      runner.filter = argv[++i];
+    } else if (arg == "--min-time" && i + 1 < argc) {
+      runner.min_time = std::stod(argv[++i]);
+    } else if (arg == "--json" && i + 1 < argc) {
+      json_fn = argv[++i];
+    } else if (arg == "--commit" && i + 1 < argc) {
+      commit = argv[++i];
+    } else {
+      std::cerr << "Unknown argument \"" << arg << "\"." << std::endl;
+      return 1;
+    }
+  }
+
+  std::string root = "../input/exact/";
+  for (std::string fn : {"exact_061.gr", "exact_161.gr", "exact_181.gr"}) {
+    std::ifstream input(root + fn);
+    GraphBenchmarks(runner, fn.substr(0, fn.find('.')), Graph(input));
+  }
+  GraphBenchmarks(runner, "random_2000_8000", RandomGraph(2000, 8000));
+  GraphBenchmarks(runner, "grid_40x40", GridGraph(40, 40));
+
+  // The tree DP on a large random tree.
+  LoadGraph(RandomGraph(100'000, 99'999));
+  runner.Run(
+      "treedepth_tree/random_tree_100000",
+      [&] { DoNotOptimize(treedepth_tree(full_graph)); }, full_graph.N);
+
+  // The lookup of the treedepth of small graphs, on random graphs.
+  std::vector<std::vector<std::vector<int>>> small_graphs;
+  for (int i = 0; i < 1000; i++) {
+    int N = 2 + rng() % (exactCacheSize - 2);
+    std::vector<std::vector<int>> adj(N);
+    for (int v = 0; v < N; v++)
+      for (int w = v + 1; w < N; w++)
+        if (rng() % 2) adj[v].push_back(w), adj[w].push_back(v);
+    small_graphs.push_back(std::move(adj));
+  }
+  runner.Run(
+      "exactCache/random",
+      [&] {
+        for (auto &adj : small_graphs) DoNotOptimize(exactCache(adj));
+      },
+      small_graphs.size());
+
+  if (!json_fn.empty()) {
+    std::ofstream json(json_fn);
+    runner.WriteJson(json, commit);
+  }
+  return 0;
+}
@@ -0,0 +1,121 @@
+#pragma once
+// A minimal micro-benchmark harness in the spirit of Google Benchmark, which
+// writes the same JSON, so that its tools (e.g. compare.py) can compare the
+// results of two commits. A benchmark is a function that does one iteration,
+// e.g.
+//   runner.Run("WithoutVertex", [&] { DoNotOptimize(G.WithoutVertex(v)); });
+// It is timed in batches of a growing number of iterations, until a batch
+// takes at least min_time seconds, and the time per iteration of that batch is
+// reported. If an iteration processes several items, their number gives an
+// items_per_second as well.
+#include <time.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cmath>
+#include <ctime>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Keeps the compiler from optimizing away the computation of value.
+template <class T>
+inline void DoNotOptimize(const T &value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+struct BenchmarkResult {
+  std::string name;
+  size_t iterations;
+  double real_time, cpu_time;  // Nanoseconds per iteration.
+  size_t items;                // Per iteration.
+};
+
+class BenchmarkRunner {
+ public:
+  double min_time = 0.5;
+
+  // Only the benchmarks whose name contains filter are run.
+  std::string filter;
+
+  std::vector<BenchmarkResult> results;
+
+  void Run(const std::string &name, const std::function<void()> &body,
+           size_t items = 0) {
+    if (name.find(filter) == std::string::npos) return;
+    size_t iterations = 1;
+    while (true) {
+      auto start = std::chrono::steady_clock::now();
+      double cpu_start = ThreadCpuTime();
+      for (size_t i = 0; i < iterations; i++) body();
+      double cpu_time = ThreadCpuTime() - cpu_start;
+      double real_time = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+      if (real_time >= min_time || iterations >= 1'000'000'000) {
+        results.push_back({name, iterations, real_time * 1e9 / iterations,
+                           cpu_time * 1e9 / iterations, items});
+        Print(results.back());
+        return;
+      }
+      // Aim for 1.4 times min_time, but grow by at most a factor 10.
+      double factor = real_time > 0 ? 1.4 * min_time / real_time : 10;
+      factor = std::min(10.0, std::max(factor, 2.0));
+      iterations = std::ceil(iterations * factor);
+    }
+  }
+
+  void WriteJson(std::ostream &stream, const std::string &commit) const {
+    char host_name[256] = "";
+    gethostname(host_name, sizeof(host_name) - 1);
+    char date[64];
+    time_t now = time(nullptr);
+    strftime(date, sizeof(date), "%FT%T%z", localtime(&now));
+    stream << std::setprecision(10) << "{\n  \"context\": {\n"
+           << "    \"date\": \"" << date << "\",\n"
+           << "    \"host_name\": \"" << host_name << "\",\n"
+           << "    \"commit\": \"" << commit << "\",\n"
+           << "    \"num_cpus\": " << std::thread::hardware_concurrency()
+           << ",\n"
+#ifdef NDEBUG
+           << "    \"library_build_type\": \"release\"\n"
+#else
+           << "    \"library_build_type\": \"debug\"\n"
+#endif
+           << "  },\n  \"benchmarks\": [";
+    for (int i = 0; i < results.size(); i++) {
+      const auto &result = results[i];
+      stream << (i ? "," : "") << "\n    {\"name\": \"" << result.name
+             << "\", \"run_type\": \"iteration\", \"iterations\": "
+             << result.iterations << ", \"real_time\": " << result.real_time
+             << ", \"cpu_time\": " << result.cpu_time
+             << ", \"time_unit\": \"ns\"";
+      if (result.items)
+        stream << ", \"items_per_second\": "
+               << result.items * 1e9 / result.real_time;
+      stream << "}";
+    }
+    stream << "\n  ]\n}" << std::endl;
+  }
+
+ private:
+  static double ThreadCpuTime() {
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+  }
+
+  static void Print(const BenchmarkResult &result) {
+    std::cout << std::left << std::setw(48) << result.name << std::right
+              << std::setw(14) << std::fixed << std::setprecision(0)
+              << result.real_time << " ns" << std::setw(14) << result.cpu_time
+              << " ns" << std::setw(12) << result.iterations;
+    if (result.items)
+      std::cout << std::setw(12) << std::setprecision(3)
+                << result.items * 1e3 / result.real_time << " M items/s";
+    std::cout << std::defaultfloat << std::endl;
+  }
+};
@@ -0,0 +1,70 @@
+#pragma once
+// Stopping a computation: a CancellationToken is cancelled by Cancel (from any
+// thread), or when its deadline passes. The computation on a thread calls
+// CheckCancelled in its loops, which throws a std::runtime_error once the
+// token of that thread (if any) is cancelled. To keep this cheap enough for
+// inner loops, the callers pass the amount of work they did since their last
+// check (think of a unit as visiting one vertex or edge), and the clock is
+// only read once every cancellation_check_work units, which takes well under
+// a millisecond.
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+
+class CancellationToken {
+ public:
+  // Makes the computation stop as soon as possible.
+  void Cancel() { cancelled.store(true, std::memory_order_relaxed); }
+
+  // Clears a cancellation, and sets the deadline to seconds from now, or
+  // removes it if seconds is not positive.
+  void Reset(double seconds = 0) {
+    cancelled.store(false, std::memory_order_relaxed);
+    start = std::chrono::steady_clock::now();
+    deadline = seconds > 0
+                   ? start + std::chrono::duration_cast<Clock::duration>(
+                                 std::chrono::duration<double>(seconds))
+                   : Clock::time_point::max();
+  }
+
+  // Whether the computation should stop, which reads the clock.
+  bool Expired() const {
+    return cancelled.load(std::memory_order_relaxed) ||
+           Clock::now() > deadline;
+  }
+
+  // Throws if the computation should stop. Only reads the clock if
+  // check_clock.
+  void Check(bool check_clock) const {
+    if (cancelled.load(std::memory_order_relaxed))
+      throw std::runtime_error("Cancelled.");
+    if (check_clock && Clock::now() > deadline)
+      throw std::runtime_error(
+          "Ran out of time, spent " +
+          std::to_string(std::chrono::duration<double>(Clock::now() - start)
+                             .count()) +
+          " seconds.");
+  }
+
+ private:
+  using Clock = std::chrono::steady_clock;
+  std::atomic<bool> cancelled = false;
+  Clock::time_point start = Clock::now();
+  Clock::time_point deadline = Clock::time_point::max();
+};
+
+// The token of the computation on this thread, if it can be stopped.
+inline thread_local const CancellationToken *cancellation_token = nullptr;
+
+const size_t cancellation_check_work = 1 << 16;
+
+// Throws if the token of this thread is cancelled, after work units of work.
+inline void CheckCancelled(size_t work = 1) {
+  thread_local size_t work_since_clock = 0;
+  if (!cancellation_token) return;
+  work_since_clock += work;
+  bool check_clock = work_since_clock >= cancellation_check_work;
+  if (check_clock) work_since_clock = 0;
+  cancellation_token->Check(check_clock);
+}
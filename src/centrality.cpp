@@ -1,7 +1,9 @@
 #include "centrality.hpp"
+#include "cancellation.hpp"
 #include <queue>
 #include <stack>
 #include <cmath>
+#include <numeric>
 
 std::vector<int> DegreeCentrality(const Graph &G) {
     std::vector<int> degree(G.N);
@@ -10,12 +12,20 @@ std::vector<int> DegreeCentrality(const Graph &G) {
     return degree;
 }
 
-std::vector<double> BetweennessCentrality(const Graph &G) {
+std::vector<double> BetweennessCentrality(
+    const Graph &G, std::chrono::steady_clock::time_point deadline) {
     int N = G.N;
 
     std::vector<double> betweenness(N, 0.0);
 
-    for(int source = 0; source < N; source++) {
+    // Visit the sources with a stride coprime to N, so that a sample cut off
+    // by the deadline is spread over the graph.
+    int stride = std::max(1, int(N * 0.618));
+    while(std::gcd(stride, N) > 1) stride++;
+
+    for(int i = 0, source = 0; i < N; i++, source = (source + stride) % N) {
+        if(i > 0 && std::chrono::steady_clock::now() > deadline)
+            break;
         std::vector<double> delta(N, 0.0);
         std::vector<double> sigma(N, 0);
         sigma[source] = 1;
@@ -31,6 +41,7 @@ std::vector<double> BetweennessCentrality(const Graph &G) {
         while(!q.empty()) {
             int cur = q.front(); q.pop();
             s.push(cur);
+            CheckCancelled(G.Adj(cur).size() + 1);
 
             for(int nb : G.Adj(cur)) {
                 if(dist[nb] == -1) {
@@ -1,8 +1,16 @@
 #pragma once
+#include <chrono>
 #include <vector>
 #include "graph.hpp"
 
 std::vector<int> DegreeCentrality(const Graph &G);
-std::vector<double> BetweennessCentrality(const Graph &G);
+
+// Brandes' algorithm, which takes O(N (N + M)) time. It stops adding the
+// paths from further sources once the deadline passes, so that the result is
+// an estimate from a sample of the sources (spread over all vertices).
+std::vector<double> BetweennessCentrality(
+    const Graph &G, std::chrono::steady_clock::time_point deadline =
+                        std::chrono::steady_clock::time_point::max());
+
 std::vector<double> EigenvectorCentrality(const Graph &G, size_t steps = 8);
 std::vector<double> PageRankCentrality(const Graph &G, size_t steps = 8, double damping = 0.85);
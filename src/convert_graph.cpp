@@ -0,0 +1,43 @@
+#include <fstream>
+#include <iostream>
+
+#include "graph_io.hpp"
+
+// Converts a graph (in the PACE or the binary format) to the binary format,
+// or with --text back to the PACE format.
+int main(int argc, char **argv) {
+  bool compress = false, text = false;
+  std::vector<std::string> fns;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--compress")
+      compress = true;
+    else if (arg == "--text")
+      text = true;
+    else
+      fns.push_back(arg);
+  }
+  if (fns.size() != 2) {
+    std::cerr << "usage: " << argv[0]
+              << " [--compress | --text] input_file output_file" << std::endl;
+    return 1;
+  }
+
+  try {
+    ParseStats stats;
+    Graph G = ReadGraph(fns[0], &stats);
+    std::ofstream output(fns[1], std::ios::binary);
+    if (text)
+      WriteGraph(G, output);
+    else
+      WriteBinaryGraph(G, output, compress);
+    if (!output) throw std::runtime_error("Could not write " + fns[1] + ".");
+    std::cerr << "Converted a graph having " << G.N << " vertices with " << G.M
+              << " edges, read at " << stats.MegabytesPerSecond() << " MB/s."
+              << std::endl;
+  } catch (std::exception &e) {
+    std::cerr << "Failed! " << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
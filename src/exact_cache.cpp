@@ -25,7 +25,8 @@ INCBIN(ExactCache8, "exact_caches/exact_cache_8.bin");
 #endif
 
 const std::vector<std::vector<int>> &exactCacheMapping(int N) {
-  static std::array<std::vector<std::vector<int>>, exactCacheSize> mappings;
+  thread_local std::array<std::vector<std::vector<int>>, exactCacheSize>
+      mappings;
   assert(N < EXACT_CACHE_SIZE);
   if (mappings[N].empty()) {
     mappings[N] = std::vector<std::vector<int>>(N, std::vector<int>(N, -1));
@@ -1,33 +1,30 @@
 #include "graph.hpp"
 
 #include <cassert>
+#include <chrono>
+#include <cstdint>
 
-Graph full_graph;
-std::vector<bool> full_graph_mask;
-std::vector<std::vector<int>> global_to_vertices;
-std::map<std::vector<int>, int> vertices_to_global;
+#include "cancellation.hpp"
+#include "graph_io.hpp"
+#include "stats.hpp"
+
+thread_local bool verbose = false;
+thread_local Graph full_graph;
+thread_local std::vector<bool> full_graph_mask;
+thread_local std::vector<int> full_graph_index;
+thread_local std::vector<std::vector<int>> global_to_vertices;
+thread_local std::map<std::vector<int>, int> vertices_to_global;
 
 int GetIndex(std::vector<int> &vertices);
 
-Graph::Graph(std::istream &stream) {
-  std::string str;
-  stream >> str;
-  assert(str == "p");
-  stream >> str;
-  assert(str == "tdp");
-  stream >> N >> M;
+Graph::Graph(std::istream &stream) : Graph(ReadGraph(stream)) {}
 
-  // Create the vector of vertices.
+Graph::Graph(int N, const std::vector<std::pair<int, int>> &edges)
+    : N(N), M(edges.size()) {
   global.reserve(N);
   for (int v = 0; v < N; v++) global.push_back(v);
   adj.resize(N);
-  for (int e = 0; e < M; e++) {
-    int a, b;
-    stream >> a >> b;
-
-    // Make them zero indexed.
-    a--, b--;
-
+  for (auto [a, b] : edges) {
     adj[a].emplace_back(b);
     adj[b].emplace_back(a);
   }
@@ -39,6 +36,19 @@ Graph::Graph(std::istream &stream) {
   full_graph_mask.resize(N, false);
 }
 
+Graph::Graph(std::vector<std::vector<int>> &&adjacency)
+    : N(adjacency.size()), adj(std::move(adjacency)) {
+  global.reserve(N);
+  for (int v = 0; v < N; v++) global.push_back(v);
+  for (int v = 0; v < N; v++) {
+    M += adj[v].size();
+    min_degree = std::min(min_degree, adj[v].size());
+    max_degree = std::max(max_degree, adj[v].size());
+  }
+  M /= 2;
+  full_graph_mask.resize(N, false);
+}
+
 Graph::Graph() {}
 
 // Create a Graph of G with the given (local) vertices
@@ -48,8 +58,12 @@ Graph::Graph(const Graph &G, std::vector<int> &sub_vertices) : Graph() {
   global.reserve(sub_vertices.size());
   adj.reserve(sub_vertices.size());
 
-  if (G.N > full_graph_mask.size()) full_graph_mask.resize(G.N, false);
-  for (int v : sub_vertices) full_graph_mask[G.global[v]] = true;
+  // The mask is per thread, so it need not have been sized for G yet.
+  for (int v : sub_vertices) {
+    if (G.global[v] >= full_graph_mask.size())
+      full_graph_mask.resize(G.global[v] + 1, false);
+    full_graph_mask[G.global[v]] = true;
+  }
 
   // This table will keep the mapping from G indices <-> indices subgraph.
   std::vector<int> new_indices(G.N, -1);
@@ -83,6 +97,8 @@ Graph::Graph(const Graph &G, std::vector<int> &sub_vertices) : Graph() {
   if (min_degree == 0) assert(sub_vertices.size() == 1 && M == 0);
   assert(M % 2 == 0);
   M /= 2;
+  STATS_INC(graph_constructions);
+  STATS_ADD(graph_bytes, sizeof(int) * (N + 2 * M));
 
   for (int v : sub_vertices) full_graph_mask[G.global[v]] = false;
 }
@@ -155,8 +171,8 @@ std::vector<Graph> Graph::ConnectedGraphs(
 
   std::vector<Graph> cc;
 
-  static std::stack<int> stack;
-  static std::vector<int> component;
+  thread_local std::stack<int> stack;
+  thread_local std::vector<int> component;
   component.reserve(sub_vertices.size());
   for (int v : sub_vertices) {
     if (!visited[v]) {
@@ -181,7 +197,7 @@ std::vector<Graph> Graph::ConnectedGraphs(
 }
 
 bool Graph::ConnectedSubset(const std::vector<int> vertices) const {
-  static std::stack<int> s;
+  thread_local std::stack<int> s;
   assert(s.empty());
   assert(vertices.size());
 
@@ -286,10 +302,10 @@ std::vector<Graph> Graph::WithoutVertices(const std::vector<int> &S) const {
 std::vector<Graph> Graph::WithoutVertex(int w) const {
   assert(w >= 0 && w < N);
   std::vector<Graph> cc;
-  static std::vector<int> stack;
+  thread_local std::vector<int> stack;
 
   // This table will keep the mapping from our indices <-> indices subgraph.
-  static std::vector<int> sub_vertices;
+  thread_local std::vector<int> sub_vertices;
   sub_vertices.reserve(N);
   std::vector<bool> visited(N, false);
 
@@ -327,37 +343,63 @@ std::vector<Graph> Graph::WithoutVertex(int w) const {
   return cc;
 }
 
+// The splitmix64 finalizer, used to hash neighborhoods.
+inline uint64_t MixVertex(uint64_t x) {
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
 std::pair<Graph, std::vector<std::vector<int>>>
 Graph::WithoutSymmetricNeighboorhoods() const {
-  // Find all pairs v, w with N(v) = N(w) or N(v)\{w} = N(w)\{v}.
+  // Find all pairs v, w with N(v) = N(w) or N(v)\{w} = N(w)\{v}, i.e. with
+  // the same open or the same closed neighborhood. Rather than comparing all
+  // pairs, we look up the (order independent) hashes of these neighborhoods,
+  // and only compare the neighborhoods themselves if the hashes match.
   std::vector<int> vertices_contract;
   std::vector<std::vector<int>> vertices_original;
-  std::vector<bool> contracted(N, false);
   std::vector<bool> in_nbh(N, false);
+  std::unordered_map<uint64_t, int> open_class, closed_class;
 
   vertices_contract.reserve(N);
   vertices_original.reserve(N);
-  for (int v = 0; v < N; v++) {
-    if (contracted[v]) continue;
-    vertices_contract.emplace_back(v);
-    vertices_original.emplace_back(std::vector<int>{v});
-    for (int nb : adj[v]) in_nbh[nb] = true;
-    for (int w = v + 1; w < N; w++) {
-      if (adj[v].size() != adj[w].size() || contracted[w]) continue;
-
-      // Check if the neighbours of w coincide with that of v.
+  for (int w = 0; w < N; w++) {
+    uint64_t open_hash = adj[w].size();
+    for (int nb : adj[w]) open_hash += MixVertex(nb);
+    uint64_t closed_hash = open_hash + 1 + MixVertex(w);
+
+    // Find the class of an earlier vertex v that is symmetric to w.
+    int c = -1;
+    for (auto [classes, hash] :
+         {std::make_pair(&open_class, open_hash),
+          std::make_pair(&closed_class, closed_hash)}) {
+      auto it = classes->find(hash);
+      if (it == classes->end()) continue;
+      int v = vertices_contract[it->second];
+      if (adj[v].size() != adj[w].size()) continue;
+      for (int nb : adj[v]) in_nbh[nb] = true;
       bool contract = true;
       for (int nb : adj[w])
         if (!in_nbh[nb] && nb != v) {
           contract = false;
           break;
         }
+      for (int nb : adj[v]) in_nbh[nb] = false;
       if (contract) {
-        vertices_original.back().emplace_back(w);
-        contracted[w] = true;
+        c = it->second;
+        break;
       }
     }
-    for (int nb : adj[v]) in_nbh[nb] = false;
+
+    if (c > -1) {
+      vertices_original[c].emplace_back(w);
+    } else {
+      open_class.emplace(open_hash, vertices_contract.size());
+      closed_class.emplace(closed_hash, vertices_contract.size());
+      vertices_contract.emplace_back(w);
+      vertices_original.emplace_back(std::vector<int>{w});
+    }
   }
 
   if (vertices_contract.size() < N)
@@ -368,33 +410,42 @@ Graph::WithoutSymmetricNeighboorhoods() const {
 
 std::vector<int> Graph::NonDominatedVertices(
     const std::vector<int> &vertices) const {
+  // Vertex v is dominated by v' if N(v) \ v' is a subset of N(v') \ v. Then
+  // v' is either a neighbor of v, or shares all neighbors with v. So for a
+  // neighbor x of v of minimal degree, we only need to look at N[x].
   std::vector<int> result;
   result.reserve(vertices.size());
+  std::vector<bool> in_vertices(N, false);
   std::vector<bool> in_nbh(N, false);
-  std::vector<bool> dominated(N, false);
-  for (int v_prime : vertices) {
-    bool contract = false;
-    for (int nb : adj[v_prime]) in_nbh[nb] = true;
-    for (int v : vertices) {
-      if (adj[v].size() > adj[v_prime].size()) continue;
-      // We want v' < v.
-      if (adj[v].size() == adj[v_prime].size() && v_prime >= v) continue;
-      if (dominated[v]) continue;
-      bool subset = true;
-      for (int nb : adj[v])
-        if (!in_nbh[nb] && nb != v_prime) {
-          subset = false;
-          break;
-        }
-      if (subset) {
-        // N(v) \ v' \subset N(v') \ v
-        dominated[v] = true;
-      }
+  for (int v : vertices) in_vertices[v] = true;
+  for (int v : vertices) {
+    if (adj[v].empty()) {
+      result.emplace_back(v);
+      continue;
     }
-    for (int nb : adj[v_prime]) in_nbh[nb] = false;
+    int x = adj[v][0];
+    for (int nb : adj[v]) {
+      in_nbh[nb] = true;
+      if (adj[nb].size() < adj[x].size()) x = nb;
+    }
+
+    bool dominated = false;
+    auto dominates = [&](int v_prime) {
+      if (v_prime == v || !in_vertices[v_prime]) return false;
+      if (adj[v].size() > adj[v_prime].size()) return false;
+      // We want v' < v.
+      if (adj[v].size() == adj[v_prime].size() && v_prime >= v) return false;
+      int shared = 0;
+      for (int nb : adj[v_prime]) shared += in_nbh[nb];
+      return shared + in_nbh[v_prime] == adj[v].size();
+    };
+    if (dominates(x)) dominated = true;
+    for (int i = 0; i < adj[x].size() && !dominated; i++)
+      dominated = dominates(adj[x][i]);
+
+    for (int nb : adj[v]) in_nbh[nb] = false;
+    if (!dominated) result.emplace_back(v);
   }
-  for (int v : vertices)
-    if (!dominated[v]) result.emplace_back(v);
   return result;
 }
 
@@ -405,7 +456,7 @@ std::vector<int> Graph::Bfs(int root) const {
   std::vector<int> result;
   result.reserve(N);
 
-  static std::queue<int> queue;
+  thread_local std::queue<int> queue;
   queue.push(root);
   visited[root] = true;
   while (!queue.empty()) {
@@ -432,7 +483,7 @@ Graph Graph::BfsTree(int root) const {
   result.global.reserve(N);
   result.adj.resize(N);
 
-  static std::queue<int> queue;
+  thread_local std::queue<int> queue;
   queue.push(root);
   visited[root] = true;
   while (!queue.empty()) {
@@ -468,7 +519,7 @@ Graph Graph::DfsTree(int root) const {
   result.global.reserve(N);
   result.adj.resize(N);
 
-  static std::vector<std::pair<int, int>> stack;
+  thread_local std::vector<std::pair<int, int>> stack;
   stack.emplace_back(root, -1);
 
   while (!stack.empty()) {
@@ -497,97 +548,204 @@ Graph Graph::DfsTree(int root) const {
   return result;
 }
 
-void ArticulationPointsHelper(const Graph &G, int u, int &d,
-                              std::vector<bool> &visited,
-                              std::vector<int> &depth, std::vector<int> &low,
-                              std::vector<int> &parent,
-                              std::vector<int> &result) {
-  int children = 0;
-  visited[u] = true;
+std::vector<int> Graph::LongPath(std::mt19937 &rng, double time_budget,
+                                 int target) const {
+  target = std::min(target, N);
+  auto deadline = std::chrono::steady_clock::now() +
+                  std::chrono::duration<double>(time_budget);
+  std::vector<int> path, best;
+  std::vector<int> position(N, -1);  // The index of a vertex on path, or -1.
+
+  // Returns the number of unvisited neighbors of v.
+  auto free_degree = [&](int v) {
+    int result = 0;
+    for (int w : Adj(v)) result += position[w] == -1;
+    return result;
+  };
+
+  // Reverses path[first, ...], updating the positions.
+  auto reverse_tail = [&](int first) {
+    std::reverse(path.begin() + first, path.end());
+    for (int i = first; i < path.size(); i++) position[path[i]] = i;
+  };
+
+  // Extends the path at its end for as long as possible. If it gets stuck at
+  // v, and v is adjacent to path[i], then reversing path[i + 1, ...] gives a
+  // path with the same vertices that ends in path[i + 1].
+  auto extend = [&]() {
+    while (true) {
+      int v = path.back(), next = -1, next_degree = INT_MAX;
+      int offset = rng() % Adj(v).size();
+      for (int j = 0; j < Adj(v).size(); j++) {
+        int w = Adj(v)[(j + offset) % Adj(v).size()];
+        if (position[w] > -1) continue;
+        int degree = free_degree(w);
+        if (degree < next_degree) {
+          next = w;
+          next_degree = degree;
+        }
+      }
+      if (next == -1) {
+        for (int w : Adj(v)) {
+          int i = position[w];
+          if (i + 2 < path.size() && free_degree(path[i + 1])) {
+            reverse_tail(i + 1);
+            next = -2;
+            break;
+          }
+        }
+        if (next == -1) return;
+        continue;
+      }
+      position[next] = path.size();
+      path.push_back(next);
+    }
+  };
+
+  do {
+    CheckCancelled(N + M);
+    for (int v : path) position[v] = -1;
+    path.assign(1, rng() % N);
+    position[path[0]] = 0;
+    if (N > 1) {
+      // Extend the path at both ends.
+      extend();
+      reverse_tail(0);
+      extend();
+    }
+    if (path.size() > best.size()) best = path;
+  } while (best.size() < target &&
+           std::chrono::steady_clock::now() < deadline);
+  return best;
+}
 
-  depth[u] = d;
-  low[u] = d;
-  d++;
+// Iterative version of the Hopcroft-Tarjan algorithm, so that deep graphs
+// don't overflow the stack. It finds the articulation points (in the order in
+// which the DFS finishes them) and, if `blocks` is given, the (local)
+// vertices of the blocks: the maximal biconnected subgraphs.
+void BiconnectedHelper(const Graph &G, std::vector<int> &articulation_points,
+                       std::vector<std::vector<int>> *blocks) {
+  std::vector<int> parent(G.N, -1);
+  std::vector<int> depth(G.N, -1);
+  std::vector<int> low(G.N, INT_MAX);
+  std::vector<int> children(G.N, 0);
+  std::vector<int> next_edge(G.N, 0);
+  std::vector<bool> is_ap(G.N, false);
+  std::vector<int> stack;
+  std::vector<int> block_stack;
+  int d = 0;
 
-  bool is_ap = false;
+  for (int root = 0; root < G.N; root++) {
+    if (depth[root] > -1) continue;
+    depth[root] = low[root] = d++;
+    stack.push_back(root);
+    block_stack.push_back(root);
+
+    while (stack.size()) {
+      int u = stack.back();
+
+      // Continue with the next edge of u.
+      if (next_edge[u] < G.Adj(u).size()) {
+        int v = G.Adj(u)[next_edge[u]++];
+        if (depth[v] == -1) {
+          children[u]++;
+          parent[v] = u;
+          depth[v] = low[v] = d++;
+          stack.push_back(v);
+          block_stack.push_back(v);
+        } else if (v != parent[u]) {
+          low[u] = std::min(low[u], depth[v]);
+        }
+        continue;
+      }
 
-  for (int v : G.Adj(u)) {
-    if (!visited[v]) {
-      children++;
-      parent[v] = u;
-      ArticulationPointsHelper(G, v, d, visited, depth, low, parent, result);
-      low[u] = std::min(low[u], low[v]);
-      if (low[v] >= depth[u]) is_ap = true;
-    } else if (v != parent[u]) {
-      low[u] = std::min(low[u], depth[v]);
+      // All children of u are done.
+      stack.pop_back();
+      if ((parent[u] == -1 && children[u] > 1) ||
+          (parent[u] != -1 && is_ap[u]))
+        articulation_points.push_back(u);
+      if (parent[u] == -1) continue;
+
+      int p = parent[u];
+      low[p] = std::min(low[p], low[u]);
+      if (low[u] >= depth[p]) {
+        // The subtree of u, together with p, contains a block.
+        is_ap[p] = true;
+        if (blocks) blocks->emplace_back(1, p);
+        int w;
+        do {
+          w = block_stack.back();
+          block_stack.pop_back();
+          if (blocks) blocks->back().push_back(w);
+        } while (w != u);
+      }
     }
+    block_stack.clear();
   }
-  if ((parent[u] == -1 && children > 1) || (parent[u] != -1 && is_ap))
-    result.push_back(u);
 }
 
 std::vector<int> Graph::ArticulationPoints() const {
-  std::vector<int> parent(N, -1);
-  std::vector<int> depth(N, INT_MAX);
-  std::vector<int> low(N, INT_MAX);
-  std::vector<bool> visited(N, false);
-  int d = 0;
-
   std::vector<int> result;
-  for (int u = 0; u < N; u++) {
-    if (!visited[u])
-      ArticulationPointsHelper(*this, u, d, visited, depth, low, parent,
-                               result);
-  }
+  BiconnectedHelper(*this, result, nullptr);
+  return result;
+}
 
+std::vector<std::vector<int>> Graph::Blocks() const {
+  std::vector<int> articulation_points;
+  std::vector<std::vector<int>> result;
+  BiconnectedHelper(*this, articulation_points, &result);
   return result;
 }
 
 std::vector<Graph> Graph::kCore(int k) const {
-  static std::vector<int> stack;
-  assert(!IsTreeGraph());
-  int vertices_left = N;
-
-  // This will keep a list of all the (local) degrees.
-  static std::vector<int> degrees;
-  if (degrees.size() < N) degrees.resize(N);
-  for (int i = 0; i < N; i++) degrees[i] = Adj(i).size();
-
-  // Remove all nodes with degree < k.
+  auto core_numbers = CoreNumbers();
+  std::vector<int> remaining;
   for (int v = 0; v < N; v++)
-    if (degrees[v] < k && degrees[v] > 0) {
-      stack.emplace_back(v);
-      degrees[v] = 0;
-      while (!stack.empty()) {
-        int v = stack.back();
-        stack.pop_back();
-        vertices_left--;
-
-        for (int nghb : Adj(v))
-          if (degrees[nghb]) {
-            --degrees[nghb];
-            if (degrees[nghb] < k && degrees[nghb]) {
-              stack.push_back(nghb);
-              degrees[nghb] = 0;
-            }
-          }
-      }
-    }
+    if (core_numbers[v] >= k) remaining.push_back(v);
 
   // Nothing was removed, simply return ourself.
-  if (vertices_left == N) return {*this};
+  if (remaining.size() == N) return {*this};
 
-  // Everything was removed, return the empty graph
-  if (vertices_left == 0) return {};
+  // Note that the subgraph does not need to be connected.
+  return ConnectedGraphs(remaining);
+}
 
-  // Note that the subgraph does not need to be connected, so
-  // ceate all subgraphs with vertices that are not removed.
-  std::vector<int> remaining;
-  remaining.reserve(vertices_left);
-  for (int v = 0; v < N; v++)
-    if (degrees[v]) remaining.emplace_back(v);
+std::vector<int> Graph::CoreNumbers() const {
+  STATS_INC(core_number_calls);
+  // The vertices sorted on their current degree, where the vertices of
+  // degree d start at bin[d].
+  std::vector<int> degree(N), bin(max_degree + 1, 0), position(N), order(N);
+  for (int v = 0; v < N; v++) bin[degree[v] = Adj(v).size()]++;
+  for (int d = 0, start = 0; d <= max_degree; d++) {
+    int count = bin[d];
+    bin[d] = start;
+    start += count;
+  }
+  for (int v = 0; v < N; v++) {
+    position[v] = bin[degree[v]]++;
+    order[position[v]] = v;
+  }
+  for (int d = max_degree; d > 0; d--) bin[d] = bin[d - 1];
+  if (N) bin[0] = 0;
 
-  return ConnectedGraphs(remaining);
+  // Remove the vertices in order of degree. Decreasing the degree of a
+  // neighbor w moves it to the front of its bin, and then into the next one.
+  for (int i = 0; i < N; i++) {
+    int v = order[i];
+    for (int w : Adj(v))
+      if (degree[w] > degree[v]) {
+        int front = bin[degree[w]], u = order[front];
+        if (u != w) {
+          order[position[w]] = u;
+          position[u] = position[w];
+          order[front] = w;
+          position[w] = front;
+        }
+        bin[degree[w]]++;
+        degree[w]--;
+      }
+  }
+  return degree;
 }
 
 Graph Graph::TwoCore() const {
@@ -629,8 +787,10 @@ Graph Graph::TwoCore() const {
   return Graph(*this, sub_vertices);
 }
 
-void LoadGraph(std::istream &stream) {
-  full_graph = Graph(stream);
+void LoadGraph(std::istream &stream) { LoadGraph(Graph(stream)); }
+
+void LoadGraph(Graph G) {
+  full_graph = std::move(G);
 
   global_to_vertices = std::vector<std::vector<int>>();
   vertices_to_global = std::map<std::vector<int>, int>();
@@ -641,10 +801,19 @@ void LoadGraph(std::istream &stream) {
     vertices_to_global[i_vec] = i;
   }
 
-  std::cerr << "Initalized a graph having " << full_graph.N << " vertices with "
+  if (verbose)
+    std::cerr << "Initalized a graph having " << full_graph.N << " vertices with "
             << full_graph.M << " edges. " << std::endl;
 }
 
+void UnloadGraph() {
+  full_graph = Graph();
+  full_graph_mask = std::vector<bool>();
+  full_graph_index = std::vector<int>();
+  global_to_vertices = std::vector<std::vector<int>>();
+  vertices_to_global = std::map<std::vector<int>, int>();
+}
+
 int GetIndex(std::vector<int> &vertices) {
   sort(vertices.begin(), vertices.end());
   auto it = vertices_to_global.find(vertices);
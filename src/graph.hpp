@@ -6,8 +6,10 @@
 #include <iostream>
 #include <map>
 #include <queue>
+#include <random>
 #include <set>
 #include <stack>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
@@ -24,9 +26,16 @@ struct Graph {
   // Create an empty Graph.
   Graph();
 
-  // Create a Graph from a stream.
+  // Create a Graph from a stream in the PACE format, see graph_io.hpp.
   Graph(std::istream &stream);
 
+  // Create a Graph on the vertices 0, ..., N - 1 with the given edges.
+  Graph(int N, const std::vector<std::pair<int, int>> &edges);
+
+  // Create a Graph on the vertices 0, ..., N - 1 with the given adjacency
+  // lists, which should be symmetric.
+  Graph(std::vector<std::vector<int>> &&adjacency);
+
   // Create a Graph of G with the given (local) vertices.
   Graph(const Graph &G, std::vector<int> &sub_vertices);
 
@@ -79,6 +88,11 @@ struct Graph {
   Graph TwoCore() const;
   std::vector<Graph> kCore(int k) const;
 
+  // Computes the core number of every vertex: the largest k such that it is
+  // in the k-core. The maximum is the degeneracy of the graph. This is the
+  // O(N + M) bucket algorithm of Batagelj and Zaversnik.
+  std::vector<int> CoreNumbers() const;
+
   // Do a BFS from the given vertex.
   std::vector<int> Bfs(int v) const;
 
@@ -86,9 +100,21 @@ struct Graph {
   Graph BfsTree(int root) const;
   Graph DfsTree(int root) const;
 
+  // Searches for a long path, by extending random paths greedily (towards the
+  // neighbor with the fewest unvisited neighbors) and rotating them when they
+  // get stuck. Restarts until time_budget seconds have passed, or a path on
+  // `target` vertices is found. Returns the (local) vertices of the longest
+  // path found.
+  std::vector<int> LongPath(std::mt19937 &rng, double time_budget,
+                            int target = INT_MAX) const;
+
   // Computes a list of all articulation points.
   std::vector<int> ArticulationPoints() const;
 
+  // Computes the (local) vertices of every block, the maximal biconnected
+  // subgraphs. Blocks that share a vertex meet in an articulation point.
+  std::vector<std::vector<int>> Blocks() const;
+
   // Returns whether this is a complete graph.
   inline bool IsCompleteGraph() const { return N * (N - 1) == 2 * M; }
 
@@ -112,12 +138,22 @@ struct Graph {
   }
 };
 
-extern Graph full_graph;                   // The full graph.
-extern std::vector<bool> full_graph_mask;  // Global variable to be reused.
+// Whether the solver reports on its progress on stderr (off by default, main
+// turns it on).
+extern thread_local bool verbose;
+
+extern thread_local Graph full_graph;  // The full graph.
+extern thread_local std::vector<bool> full_graph_mask;  // To be reused.
+// From global coordinates to those of a subgraph, -1 when not in use.
+extern thread_local std::vector<int> full_graph_index;
 
 // For going from global coordinates to sets of original vertices, and back.
-extern std::vector<std::vector<int>> global_to_vertices;
-extern std::map<std::vector<int>, int> vertices_to_global;
+extern thread_local std::vector<std::vector<int>> global_to_vertices;
+extern thread_local std::map<std::vector<int>, int> vertices_to_global;
 
 // This initalizes the above global variables, important!
 void LoadGraph(std::istream &stream);
+void LoadGraph(Graph G);
+
+// Frees the memory of the above global variables, for a thread that is done.
+void UnloadGraph();
@@ -0,0 +1,427 @@
+#include "graph_io.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+
+Graph CsrGraph::ToGraph() const {
+  std::vector<std::vector<int>> adj(N);
+  for (int v = 0; v < N; v++)
+    adj[v].assign(targets.begin() + offsets[v],
+                  targets.begin() + offsets[v + 1]);
+  return Graph(std::move(adj));
+}
+
+namespace {
+
+// A hand-written tokenizer, as going through a std::istream one token at a
+// time is slow for large graphs.
+class Parser {
+ public:
+  Parser(const char *begin, const char *end)
+      : begin(begin), end(end), p(begin) {}
+
+  int ReadInt() {
+    SkipToToken();
+    long long value = 0;
+    const char *start = p;
+    while (p < end && *p >= '0' && *p <= '9') {
+      value = 10 * value + (*p++ - '0');
+      if (value > INT_MAX) Error("Number out of range.");
+    }
+    if (p == start || !AtSpace()) Error("Expected a number.");
+    return value;
+  }
+
+  void ReadWord(const char *word) {
+    SkipToToken();
+    const char *w = word;
+    while (*w && p < end && *p == *w) p++, w++;
+    if (*w || !AtSpace()) Error("Expected \"" + std::string(word) + "\".");
+  }
+
+  [[noreturn]] void Error(const std::string &message) {
+    int line = 1;
+    for (const char *q = begin; q < p && q < end; q++) line += *q == '\n';
+    throw std::runtime_error("Invalid graph on line " + std::to_string(line) +
+                             ": " + message);
+  }
+
+ private:
+  // Skips whitespace and comment lines.
+  void SkipToToken() {
+    while (p < end) {
+      if (*p == 'c' && (p == begin || p[-1] == '\n')) {
+        while (p < end && *p != '\n') p++;
+      } else if (*p == ' ' || *p == '\n' || *p == '\t' || *p == '\r') {
+        p++;
+      } else {
+        return;
+      }
+    }
+    Error("Unexpected end of input.");
+  }
+
+  bool AtSpace() const {
+    return p == end || *p == ' ' || *p == '\n' || *p == '\t' || *p == '\r';
+  }
+
+  const char *begin, *end, *p;
+};
+
+}  // namespace
+
+CsrGraph ParseGraph(const char *begin, const char *end, ParseStats *stats) {
+  Parser parser(begin, end);
+  parser.ReadWord("p");
+  parser.ReadWord("tdp");
+  CsrGraph G;
+  G.N = parser.ReadInt();
+  int M = parser.ReadInt();
+
+  // Read the edges, and count the degrees.
+  std::vector<std::pair<int, int>> edges;
+  edges.reserve(std::min<size_t>(M, (end - begin) / 4));
+  std::vector<int> degree(G.N, 0);
+  size_t self_loops = 0;
+  for (int e = 0; e < M; e++) {
+    int a = parser.ReadInt(), b = parser.ReadInt();
+    if (a < 1 || b < 1 || a > G.N || b > G.N)
+      parser.Error("Vertex out of range.");
+    if (a == b) {
+      self_loops++;
+      continue;
+    }
+    edges.emplace_back(a - 1, b - 1);
+    degree[a - 1]++;
+    degree[b - 1]++;
+  }
+
+  // Fill in the neighbours, in order of appearance.
+  G.offsets.resize(G.N + 1);
+  for (int v = 0; v < G.N; v++) G.offsets[v + 1] = G.offsets[v] + degree[v];
+  G.targets.resize(G.offsets[G.N]);
+  std::vector<size_t> fill(G.offsets.begin(), G.offsets.end() - 1);
+  for (auto [a, b] : edges) {
+    G.targets[fill[a]++] = b;
+    G.targets[fill[b]++] = a;
+  }
+
+  // Remove the multi-edges, by marking the neighbours of every vertex.
+  std::vector<int> mark(G.N, -1);
+  size_t size = 0, start = 0;
+  for (int v = 0; v < G.N; v++) {
+    for (size_t i = start; i < G.offsets[v + 1]; i++) {
+      int w = G.targets[i];
+      if (mark[w] == v) continue;
+      mark[w] = v;
+      G.targets[size++] = w;
+    }
+    start = G.offsets[v + 1];
+    G.offsets[v + 1] = size;
+  }
+  size_t duplicates = (G.targets.size() - size) / 2;
+  G.targets.resize(size);
+  G.targets.shrink_to_fit();
+
+  if (stats) {
+    stats->self_loops = self_loops;
+    stats->duplicate_edges = duplicates;
+  }
+  return G;
+}
+
+#if __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "The binary graph format assumes a little-endian machine."
+#endif
+
+namespace {
+
+const size_t binary_graph_header_size = 24;
+
+template <class T>
+T Load(const char *p) {
+  T value;
+  std::memcpy(&value, p, sizeof(T));
+  return value;
+}
+
+template <class T>
+void Store(std::ostream &stream, T value) {
+  stream.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+[[noreturn]] void InvalidBinaryGraph(const std::string &message) {
+  throw std::runtime_error("Invalid binary graph: " + message);
+}
+
+// Graph(adj) relies on adjacency lists without self-loops or duplicates, in
+// which w is a neighbour of v iff v is a neighbour of w. Checks these in
+// O(N + M): the smaller neighbours of every vertex must be the vertices that
+// list it as a larger neighbour, which are collected in CSR form.
+void ValidateAdjacency(const std::vector<std::vector<int>> &adj) {
+  int N = adj.size();
+  std::vector<uint32_t> offsets(N + 1, 0);
+  for (int v = 0; v < N; v++)
+    for (int w : adj[v])
+      if (w > v) offsets[w + 1]++;
+  for (int v = 0; v < N; v++) offsets[v + 1] += offsets[v];
+  std::vector<int> smaller(offsets[N]);
+  std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+  for (int v = 0; v < N; v++)
+    for (int w : adj[v])
+      if (w > v) smaller[fill[w]++] = v;
+
+  std::vector<int> mark(N, -1);
+  for (int v = 0; v < N; v++) {
+    size_t num_smaller = 0;
+    for (int w : adj[v]) {
+      if (w == v) InvalidBinaryGraph("Self-loop.");
+      if (mark[w] == v) InvalidBinaryGraph("Duplicate neighbour.");
+      mark[w] = v;
+      num_smaller += w < v;
+    }
+    // Both lists are free of duplicates, so they are equal if they have the
+    // same size and the one contains the other.
+    if (num_smaller != offsets[v + 1] - offsets[v])
+      InvalidBinaryGraph("Asymmetric adjacency.");
+    for (size_t i = offsets[v]; i < offsets[v + 1]; i++)
+      if (mark[smaller[i]] != v) InvalidBinaryGraph("Asymmetric adjacency.");
+  }
+}
+
+}  // namespace
+
+bool IsBinaryGraph(const char *begin, const char *end) {
+  return end - begin >= 8 && std::memcmp(begin, binary_graph_magic, 8) == 0;
+}
+
+Graph ParseBinaryGraph(const char *begin, const char *end) {
+  if (!IsBinaryGraph(begin, end) || end - begin < binary_graph_header_size)
+    InvalidBinaryGraph("Truncated header.");
+  uint32_t flags = Load<uint32_t>(begin + 8);
+  uint32_t N = Load<uint32_t>(begin + 12);
+  uint64_t size = Load<uint64_t>(begin + 16);
+  bool compressed = flags & binary_graph_compressed;
+  if (flags & ~binary_graph_compressed) InvalidBinaryGraph("Unknown flags.");
+  if (N > INT_MAX) InvalidBinaryGraph("Too many vertices.");
+
+  const char *offsets = begin + binary_graph_header_size;
+  if ((end - offsets) / 8 < uint64_t(N) + 1) InvalidBinaryGraph("Truncated.");
+  const char *neighbours = offsets + 8 * (uint64_t(N) + 1);
+  if ((end - neighbours) / (compressed ? 1 : 4) < size)
+    InvalidBinaryGraph("Truncated.");
+  if (Load<uint64_t>(offsets) != 0 || Load<uint64_t>(offsets + 8 * N) != size)
+    InvalidBinaryGraph("Invalid offsets.");
+
+  std::vector<std::vector<int>> adj(N);
+  for (int v = 0; v < N; v++) {
+    uint64_t from = Load<uint64_t>(offsets + 8 * v);
+    uint64_t to = Load<uint64_t>(offsets + 8 * (v + 1));
+    if (to < from || to > size) InvalidBinaryGraph("Invalid offsets.");
+    if (!compressed) {
+      adj[v].resize(to - from);
+      std::memcpy(adj[v].data(), neighbours + 4 * from, 4 * (to - from));
+      for (int w : adj[v])
+        if (w < 0 || w >= N) InvalidBinaryGraph("Vertex out of range.");
+      continue;
+    }
+    const unsigned char *p =
+        reinterpret_cast<const unsigned char *>(neighbours) + from;
+    const unsigned char *p_end = p + (to - from);
+    int64_t w = v;
+    while (p < p_end) {
+      uint64_t zigzag = 0;
+      for (int shift = 0;; shift += 7) {
+        if (p == p_end || shift > 63) InvalidBinaryGraph("Invalid varint.");
+        zigzag |= uint64_t(*p & 127) << shift;
+        if (!(*p++ & 128)) break;
+      }
+      w += int64_t(zigzag >> 1) ^ -int64_t(zigzag & 1);
+      if (w < 0 || w >= N) InvalidBinaryGraph("Vertex out of range.");
+      adj[v].push_back(w);
+    }
+  }
+  ValidateAdjacency(adj);
+  return Graph(std::move(adj));
+}
+
+void WriteBinaryGraph(const Graph &G, std::ostream &stream, bool compress) {
+  std::vector<uint64_t> offsets{0};
+  std::vector<uint32_t> targets;
+  std::string bytes;
+  for (int v = 0; v < G.N; v++) {
+    int64_t previous = v;
+    for (int w : G.adj[v]) {
+      if (compress) {
+        int64_t difference = w - previous;
+        uint64_t zigzag = (uint64_t(difference) << 1) ^ (difference >> 63);
+        for (; zigzag >= 128; zigzag >>= 7) bytes.push_back(zigzag | 128);
+        bytes.push_back(zigzag);
+      } else {
+        targets.push_back(w);
+      }
+      previous = w;
+    }
+    offsets.push_back(compress ? bytes.size() : targets.size());
+  }
+
+  stream.write(binary_graph_magic, 8);
+  Store<uint32_t>(stream, compress ? binary_graph_compressed : 0);
+  Store<uint32_t>(stream, G.N);
+  Store<uint64_t>(stream, offsets.back());
+  stream.write(reinterpret_cast<const char *>(offsets.data()),
+               8 * offsets.size());
+  if (compress)
+    stream.write(bytes.data(), bytes.size());
+  else
+    stream.write(reinterpret_cast<const char *>(targets.data()),
+                 4 * targets.size());
+}
+
+void WriteGraph(const Graph &G, std::ostream &stream) {
+  stream << "p tdp " << G.N << " " << G.M << '\n';
+  for (int v = 0; v < G.N; v++)
+    for (int w : G.adj[v])
+      if (v < w) stream << v + 1 << " " << w + 1 << '\n';
+}
+
+void WriteTree(int fd, int depth, const std::vector<int> &tree, bool binary) {
+  std::string buffer;
+  if (binary) {
+    buffer.resize(16 + 4 * tree.size());
+    std::memcpy(&buffer[0], binary_tree_magic, 8);
+    uint32_t header[2] = {uint32_t(tree.size()), uint32_t(depth)};
+    std::memcpy(&buffer[8], header, 8);
+    for (size_t v = 0; v < tree.size(); v++) {
+      uint32_t parent = tree[v];
+      std::memcpy(&buffer[16 + 4 * v], &parent, 4);
+    }
+  } else {
+    // At most 11 characters and a newline per number.
+    buffer.resize(12 * (tree.size() + 1));
+    char *p = &buffer[0];
+    auto format = [&p](int value) {
+      char digits[12];
+      int count = 0;
+      unsigned magnitude = value < 0 ? -unsigned(value) : value;
+      do {
+        digits[count++] = '0' + magnitude % 10;
+        magnitude /= 10;
+      } while (magnitude);
+      if (value < 0) *p++ = '-';
+      while (count) *p++ = digits[--count];
+      *p++ = '\n';
+    };
+    format(depth);
+    for (int parent : tree) format(parent);
+    buffer.resize(p - &buffer[0]);
+  }
+
+  const char *data = buffer.data();
+  size_t left = buffer.size();
+  while (left) {
+    ssize_t count = write(fd, data, left);
+    if (count < 0 && errno == EINTR) continue;
+    if (count <= 0) throw std::runtime_error("Could not write the tree.");
+    data += count;
+    left -= count;
+  }
+}
+
+void WriteTree(const std::string &fn, int depth, const std::vector<int> &tree,
+               bool binary) {
+  int fd = open(fn.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) throw std::runtime_error("Could not open " + fn + ".");
+  try {
+    WriteTree(fd, depth, tree, binary);
+  } catch (...) {
+    close(fd);
+    throw;
+  }
+  if (close(fd)) throw std::runtime_error("Could not write " + fn + ".");
+}
+
+namespace {
+
+// Parses [begin, end), in either format, and fills in the statistics.
+Graph ParseAndTime(const char *begin, const char *end,
+                   std::chrono::steady_clock::time_point start,
+                   ParseStats *stats) {
+  Graph G = IsBinaryGraph(begin, end) ? ParseBinaryGraph(begin, end)
+                                      : ParseGraph(begin, end, stats).ToGraph();
+  if (stats) {
+    stats->bytes = end - begin;
+    stats->seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+  }
+  return G;
+}
+
+}  // namespace
+
+Graph ReadGraph(int fd, ParseStats *stats) {
+  auto start = std::chrono::steady_clock::now();
+  struct stat status;
+  if (fstat(fd, &status) == 0 && S_ISREG(status.st_mode) &&
+      status.st_size > 0) {
+    off_t offset = lseek(fd, 0, SEEK_CUR);
+    if (offset < 0) offset = 0;
+    void *data = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data != MAP_FAILED) {
+      madvise(data, status.st_size, MADV_SEQUENTIAL);
+      const char *begin = static_cast<const char *>(data);
+      try {
+        Graph G = ParseAndTime(begin + offset, begin + status.st_size, start,
+                               stats);
+        munmap(data, status.st_size);
+        return G;
+      } catch (...) {
+        munmap(data, status.st_size);
+        throw;
+      }
+    }
+  }
+
+  // A pipe (or mmap failed), read it in blocks.
+  std::string text;
+  const size_t block = 1 << 20;
+  while (true) {
+    size_t size = text.size();
+    text.resize(size + block);
+    ssize_t count = read(fd, &text[size], block);
+    if (count < 0) throw std::runtime_error("Could not read the graph.");
+    text.resize(size + count);
+    if (count == 0) break;
+  }
+  return ParseAndTime(text.data(), text.data() + text.size(), start, stats);
+}
+
+Graph ReadGraph(const std::string &fn, ParseStats *stats) {
+  int fd = open(fn.c_str(), O_RDONLY);
+  if (fd < 0) throw std::runtime_error("Could not open " + fn + ".");
+  try {
+    Graph G = ReadGraph(fd, stats);
+    close(fd);
+    return G;
+  } catch (...) {
+    close(fd);
+    throw;
+  }
+}
+
+Graph ReadGraph(std::istream &stream, ParseStats *stats) {
+  auto start = std::chrono::steady_clock::now();
+  std::string text(std::istreambuf_iterator<char>(stream), {});
+  return ParseAndTime(text.data(), text.data() + text.size(), start, stats);
+}
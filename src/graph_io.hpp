@@ -0,0 +1,80 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "graph.hpp"
+
+// A graph in compressed sparse row form: the neighbours of v are
+// targets[offsets[v]], ..., targets[offsets[v + 1] - 1].
+struct CsrGraph {
+  int N = 0;
+  std::vector<size_t> offsets{0};
+  std::vector<int> targets;
+
+  Graph ToGraph() const;
+};
+
+// Statistics of reading a graph.
+struct ParseStats {
+  size_t bytes = 0;
+  double seconds = 0;
+  size_t self_loops = 0;       // Dropped.
+  size_t duplicate_edges = 0;  // Dropped.
+
+  double MegabytesPerSecond() const { return bytes / 1e6 / seconds; }
+};
+
+// Parses a graph in the PACE format, that is a line "p tdp N M" followed by M
+// lines "a b" with 1 <= a, b <= N, from the characters in [begin, end). Lines
+// starting with 'c' are comments. Self-loops and multi-edges are dropped, and
+// anything after the M-th edge is ignored. Throws a std::runtime_error with the
+// offending line on malformed input.
+CsrGraph ParseGraph(const char *begin, const char *end,
+                    ParseStats *stats = nullptr);
+
+// The binary format, for graphs that are solved over and over again, stores
+// the adjacency lists in CSR form. It consists of (all little-endian):
+// - the 8 characters of binary_graph_magic,
+// - a uint32 of flags, which may contain binary_graph_compressed,
+// - a uint32 N, and a uint64 size,
+// - N + 1 uint64 offsets, with offsets[0] = 0 and offsets[N] = size,
+// - the neighbours: size uint32s, where those of v are at indices offsets[v],
+//   ..., offsets[v + 1] - 1. If compressed, size bytes instead, where the
+//   neighbours of v are varints of the zigzag encoded differences to the
+//   previous neighbour (or to v, for the first one), at the bytes offsets[v],
+//   ..., offsets[v + 1] - 1.
+// The neighbours keep their order, and both directions of an edge are stored.
+constexpr char binary_graph_magic[] = "tdULLcsr";
+const uint32_t binary_graph_compressed = 1;
+
+// Parses a graph in the binary format, throws a std::runtime_error if it is
+// not valid, which includes self-loops, duplicate neighbours, and edges that
+// are stored in one direction only.
+bool IsBinaryGraph(const char *begin, const char *end);
+Graph ParseBinaryGraph(const char *begin, const char *end);
+
+// Writes G in the binary or the PACE format.
+void WriteBinaryGraph(const Graph &G, std::ostream &stream,
+                      bool compress = false);
+void WriteGraph(const Graph &G, std::ostream &stream);
+
+// Writes a decomposition: its depth, followed by the parent of every vertex
+// (1-based, 0 for a root), in the PACE format, or in the binary format: the 8
+// characters of binary_tree_magic, a uint32 N, a uint32 depth, and the N
+// parents as uint32s (little-endian). Everything is formatted into one buffer,
+// which is written with a single write. Throws a std::runtime_error if that
+// fails.
+constexpr char binary_tree_magic[] = "tdULLtre";
+void WriteTree(int fd, int depth, const std::vector<int> &tree,
+               bool binary = false);
+void WriteTree(const std::string &fn, int depth, const std::vector<int> &tree,
+               bool binary = false);
+
+// Reads a graph in the PACE or the binary format (detected by its magic) from
+// a file descriptor, which is mmapped if it is a regular file (this includes
+// `main < file`), and else read in large blocks. The streams version reads all
+// that is left in the stream.
+Graph ReadGraph(int fd, ParseStats *stats = nullptr);
+Graph ReadGraph(const std::string &fn, ParseStats *stats = nullptr);
+Graph ReadGraph(std::istream &stream, ParseStats *stats = nullptr);
@@ -0,0 +1,202 @@
+#include "graph_io.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+// The checks must run in the release build as well.
+#undef NDEBUG
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <sstream>
+
+CsrGraph Parse(const std::string &text, ParseStats *stats = nullptr) {
+  return ParseGraph(text.data(), text.data() + text.size(), stats);
+}
+
+bool Fails(const std::string &text) {
+  try {
+    Parse(text);
+  } catch (std::runtime_error &e) {
+    return true;
+  }
+  return false;
+}
+
+bool FailsBinary(const std::string &str) {
+  try {
+    ParseBinaryGraph(str.data(), str.data() + str.size());
+  } catch (std::runtime_error &e) {
+    return true;
+  }
+  return false;
+}
+
+int main() {
+  // Comments, self-loops and multi-edges.
+  ParseStats stats;
+  Graph G = Parse(
+                "c a comment\np tdp 4 6\nc another one\n1 2\n2 3\n3 2\n"
+                "4 4\n1 2\n3 4\n",
+                &stats)
+                .ToGraph();
+  assert(G.N == 4 && G.M == 3);
+  assert(G.adj[1] == std::vector<int>({0, 2}));
+  assert(G.adj[3] == std::vector<int>({2}));
+  assert(stats.self_loops == 1 && stats.duplicate_edges == 2);
+
+  // The input of the old parser still works.
+  std::stringstream stream("p tdp 3 2 1 2 2 3");
+  G = Graph(stream);
+  assert(G.N == 3 && G.M == 2 && G.max_degree == 2 && G.min_degree == 1);
+  assert(Parse("p tdp 1 0").N == 1);
+
+  // Malformed input.
+  assert(Fails(""));
+  assert(Fails("p td 2 1\n1 2\n"));
+  assert(Fails("p tdp 2 2\n1 2\n"));
+  assert(Fails("p tdp 2 1\n1 3\n"));
+  assert(Fails("p tdp 2 1\n0 1\n"));
+  assert(Fails("p tdp 2 1\n1 -2\n"));
+  assert(Fails("p tdp 2 1\n1 2x\n"));
+  assert(Fails("p tdp 2 1\n1 99999999999\n"));
+
+  // Reading from a file.
+  std::string fn = "graph_io_test.gr";
+  {
+    std::ofstream file(fn);
+    file << "p tdp 3 2\n1 2\n2 3\n";
+  }
+  G = ReadGraph(fn);
+  std::remove(fn.c_str());
+  assert(G.N == 3 && G.M == 2);
+
+  // The binary format, plain and compressed, keeps the order of neighbours.
+  G = Parse("p tdp 5 5\n5 1\n1 2\n2 3\n3 1\n4 1\n").ToGraph();
+  for (bool compress : {false, true}) {
+    std::stringstream binary;
+    WriteBinaryGraph(G, binary, compress);
+    std::string str = binary.str();
+    assert(IsBinaryGraph(str.data(), str.data() + str.size()));
+    Graph H = ParseBinaryGraph(str.data(), str.data() + str.size());
+    assert(H.N == 5 && H.M == 5 && H.adj == G.adj);
+    std::stringstream stream(str);
+    assert(Graph(stream).adj == G.adj);
+
+    // Truncated or corrupted files.
+    assert(FailsBinary(str.substr(0, str.size() - 1)));
+    str[str.size() - 1] = compress ? 100 : 5;
+    assert(FailsBinary(str));
+  }
+  // Self-loops, duplicate neighbours and edges in one direction only.
+  for (auto adj : std::vector<std::vector<std::vector<int>>>{
+           {{0}}, {{1, 1}, {0, 0}}, {{1}, {}}, {{1, 2}, {2}, {0, 1}}})
+    for (bool compress : {false, true}) {
+      std::stringstream binary;
+      WriteBinaryGraph(Graph(std::vector<std::vector<int>>(adj)), binary,
+                       compress);
+      assert(FailsBinary(binary.str()));
+    }
+
+  std::stringstream text;
+  WriteGraph(G, text);
+  assert(Parse(text.str()).ToGraph().M == 5);
+
+  std::mt19937 rng(42);
+
+  // Writing trees, in both formats.
+  WriteTree(fn, 3, {0, 1, 1, 2});
+  std::ifstream tree_file(fn);
+  std::string tree_text(std::istreambuf_iterator<char>(tree_file), {});
+  assert(tree_text == "3\n0\n1\n1\n2\n");
+  WriteTree(fn, 3, {0, 1, 1, 2}, /*binary=*/true);
+  tree_file = std::ifstream(fn, std::ios::binary);
+  tree_text.assign(std::istreambuf_iterator<char>(tree_file), {});
+  assert(tree_text.size() == 32 && tree_text.compare(0, 8, "tdULLtre") == 0);
+  std::remove(fn.c_str());
+
+  // Writing a tree with a million vertices, compared to std::endl per line.
+  {
+    std::vector<int> tree(1'000'000);
+    for (int v = 1; v < tree.size(); v++) tree[v] = rng() % v + 1;
+    int fd = open("/dev/null", O_WRONLY);
+    auto start = std::chrono::steady_clock::now();
+    WriteTree(fd, 20, tree);
+    double time = std::chrono::duration<double>(
+                      std::chrono::steady_clock::now() - start)
+                      .count();
+    close(fd);
+    std::ofstream null("/dev/null");
+    start = std::chrono::steady_clock::now();
+    null << 20 << std::endl;
+    for (int parent : tree) null << parent << std::endl;
+    double time_endl = std::chrono::duration<double>(
+                           std::chrono::steady_clock::now() - start)
+                           .count();
+    std::cout << "Writing a tree of 1M vertices took " << time
+              << " seconds, with std::endl " << time_endl << " seconds."
+              << std::endl;
+  }
+
+  // Throughput on large random graphs, compared to reading with a stream.
+  for (int N : {100'000, 1'000'000}) {
+    int M = 5 * N;
+    std::stringstream text;
+    text << "c random graph\np tdp " << N << " " << M << "\n";
+    for (int e = 0; e < M; e++)
+      text << rng() % N + 1 << " " << rng() % N + 1 << "\n";
+    std::string str = text.str();
+
+    G = Parse(str, &stats).ToGraph();
+    auto start = std::chrono::steady_clock::now();
+    const int repeat = 3;
+    for (int i = 0; i < repeat; i++) G = Parse(str).ToGraph();
+    double time = std::chrono::duration<double>(
+                      std::chrono::steady_clock::now() - start)
+                      .count() /
+                  repeat;
+
+    start = std::chrono::steady_clock::now();
+    std::stringstream stream(str);
+    std::string line;
+    std::getline(stream, line);
+    std::getline(stream, line);
+    std::vector<std::vector<int>> adj(N);
+    for (int e = 0; e < M; e++) {
+      int a, b;
+      stream >> a >> b;
+      adj[a - 1].push_back(b - 1);
+      adj[b - 1].push_back(a - 1);
+    }
+    double time_stream = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+
+    assert(G.N == N && G.M == M - stats.self_loops - stats.duplicate_edges);
+    std::cout << "Parsing " << str.size() / 1e6 << " MB took " << time
+              << " seconds (" << str.size() / 1e6 / time << " MB/s), with a "
+              << "stream " << time_stream << " seconds ("
+              << str.size() / 1e6 / time_stream << " MB/s)." << std::endl;
+
+    // And the binary format.
+    for (bool compress : {false, true}) {
+      std::stringstream binary;
+      WriteBinaryGraph(G, binary, compress);
+      std::string bin = binary.str();
+      start = std::chrono::steady_clock::now();
+      Graph H = ParseBinaryGraph(bin.data(), bin.data() + bin.size());
+      double time_binary = std::chrono::duration<double>(
+                               std::chrono::steady_clock::now() - start)
+                               .count();
+      assert(H.adj == G.adj);
+      std::cout << "Loading the " << (compress ? "compressed " : "")
+                << "binary format of " << bin.size() / 1e6 << " MB took "
+                << time_binary << " seconds." << std::endl;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,142 @@
+#include "graph.hpp"
+
+// The checks must run in the release build as well.
+#undef NDEBUG
+#include <cassert>
+#include <numeric>
+#include <set>
+#include <sstream>
+
+// Helper function to verify the blocks: every edge lies in exactly one block,
+// the blocks are biconnected, and the vertices that lie in more than one block
+// are exactly the articulation points, which are the vertices whose removal
+// disconnects the graph.
+void TestBlocks(const Graph &G) {
+  std::vector<int> num_blocks(G.N, 0);
+  std::set<std::pair<int, int>> edges;
+  for (auto block : G.Blocks()) {
+    std::set<int> in_block(block.begin(), block.end());
+    for (int v : block) {
+      num_blocks[v]++;
+      for (int nb : G.Adj(v))
+        if (v < nb && in_block.count(nb)) assert(edges.insert({v, nb}).second);
+    }
+    if (block.size() < G.N)
+      assert(Graph(G, block).ArticulationPoints().empty());
+  }
+  assert(edges.size() == G.M);
+
+  std::vector<int> aps_real;
+  for (int v = 0; v < G.N; v++) {
+    if (num_blocks[v] > 1) aps_real.push_back(v);
+    assert((num_blocks[v] > 1) == (G.WithoutVertex(v).size() > 1));
+  }
+  std::vector<int> aps = G.ArticulationPoints();
+  std::sort(aps.begin(), aps.end());
+  assert(aps == aps_real);
+}
+
+// Helper function to verify NonDominatedVertices against the definition: v is
+// dominated by v' if N(v) \ v' is a subset of N(v') (with ties broken on the
+// degree and index).
+void TestNonDominatedVertices(const Graph &G) {
+  std::vector<int> vertices(G.N);
+  std::iota(vertices.begin(), vertices.end(), 0);
+  std::vector<int> non_dominated_real;
+  for (int v = 0; v < G.N; v++) {
+    bool dominated = false;
+    std::set<int> nbh(G.Adj(v).begin(), G.Adj(v).end());
+    for (int v_prime = 0; v_prime < G.N; v_prime++) {
+      if (v_prime == v || G.Adj(v).size() > G.Adj(v_prime).size()) continue;
+      if (G.Adj(v).size() == G.Adj(v_prime).size() && v_prime > v) continue;
+      std::set<int> nbh_prime(G.Adj(v_prime).begin(), G.Adj(v_prime).end());
+      nbh_prime.insert(v_prime);
+      if (std::includes(nbh_prime.begin(), nbh_prime.end(), nbh.begin(),
+                        nbh.end()))
+        dominated = true;
+    }
+    if (!dominated) non_dominated_real.push_back(v);
+  }
+  assert(G.NonDominatedVertices(vertices) == non_dominated_real);
+}
+
+// Checks that LongPath returns a path of G.
+void TestLongPath(const Graph &G) {
+  std::mt19937 rng(42);
+  auto path = G.LongPath(rng, 0.001);
+  assert(path.size() > 0 && path.size() <= G.N);
+  std::set<int> vertices(path.begin(), path.end());
+  assert(vertices.size() == path.size());
+  for (int i = 1; i < path.size(); i++) {
+    const auto &adj = G.Adj(path[i - 1]);
+    assert(std::find(adj.begin(), adj.end(), path[i]) != adj.end());
+  }
+}
+
+// Compares CoreNumbers to peeling every k-core by hand.
+void TestCoreNumbers(const Graph &G) {
+  auto core_numbers = G.CoreNumbers();
+  for (int k = 0; k <= G.max_degree + 1; k++) {
+    std::vector<bool> removed(G.N, false);
+    bool changed = true;
+    while (changed) {
+      changed = false;
+      for (int v = 0; v < G.N; v++) {
+        if (removed[v]) continue;
+        int degree = 0;
+        for (int w : G.Adj(v)) degree += !removed[w];
+        if (degree < k) removed[v] = changed = true;
+      }
+    }
+    for (int v = 0; v < G.N; v++) assert(removed[v] == (core_numbers[v] < k));
+  }
+}
+
+int main() {
+  std::vector<std::string> graphs{
+      // exact_015.gr.
+      "p tdp 26 30 18 22 18 13 22 23 22 9 22 2 22 4 22 20 22 24 22 12 10 11 10 "
+      "7 10 14 11 1 11 26 11 21 14 26 26 7 2 13 6 17 17 16 17 12 17 19 17 8 17 "
+      "15 1 5 1 13 13 21 13 25 13 24 12 3",
+      "p tdp 11 12 1 2 2 3 3 1 3 4 4 5 5 6 6 7 7 4 6 8 7 9 9 10 10 11",
+      "p tdp 11 14 1 2 2 3 3 1 3 4 4 5 5 6 6 7 7 4 6 8 7 9 9 10 10 11 4 6 5 7",
+      "p tdp 6 5 1 2 1 3 1 4 1 5 1 6", "p tdp 6 6 1 2 2 3 3 4 4 5 5 6 6 1",
+      "p tdp 6 6 1 2 2 3 3 4 4 1 3 5 4 6"};
+
+  // Random connected graphs of various densities.
+  std::mt19937 rng(42);
+  for (int i = 0; i < 20; i++) {
+    int N = 5 + rng() % 40, extra = rng() % (2 * N);
+    std::set<std::pair<int, int>> edges;
+    for (int v = 2; v <= N; v++) edges.emplace(1 + rng() % (v - 1), v);
+    for (int e = 0; e < extra; e++) {
+      int a = 1 + rng() % N, b = 1 + rng() % N;
+      if (a < b) edges.emplace(a, b);
+    }
+    std::stringstream graph;
+    graph << "p tdp " << N << " " << edges.size();
+    for (auto [a, b] : edges) graph << " " << a << " " << b;
+    graphs.push_back(graph.str());
+  }
+
+  for (auto &graph : graphs) {
+    std::istringstream stream(graph);
+    LoadGraph(stream);
+    TestBlocks(full_graph);
+    TestNonDominatedVertices(full_graph);
+    TestLongPath(full_graph);
+    TestCoreNumbers(full_graph);
+  }
+
+  // Deep graphs should not overflow the stack.
+  const int path_N = 200'000;
+  std::stringstream stream_path;
+  stream_path << "p tdp " << path_N << " " << path_N - 1;
+  for (int v = 1; v < path_N; v++) stream_path << " " << v << " " << v + 1;
+  LoadGraph(stream_path);
+  auto aps_path = full_graph.ArticulationPoints();
+  auto blocks_path = full_graph.Blocks();
+  assert(aps_path.size() == path_N - 2 && blocks_path.size() == path_N - 1);
+  assert(full_graph.LongPath(rng, 0).size() == path_N);
+  return 0;
+}
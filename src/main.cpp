@@ -1,15 +1,269 @@
+#include <fcntl.h>
+#include <unistd.h>
+
 #include <chrono>
 #include <cmath>
 #include <exception>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <tuple>
 
+#include "graph_io.hpp"
 #include "treedepth.hpp"
 
 std::string ExtractFileName(const std::string& str) {
   return str.substr(str.find_last_of("/") + 1);
 }
 
+// Reads the next graph from a stream of concatenated PACE graphs into text,
+// skipping comments. Returns false if the stream has no graphs left.
+bool ReadNextGraph(std::istream& stream, std::string& text) {
+  std::stringstream graph;
+  std::string line;
+  int edges_left = -1;
+  while (edges_left && std::getline(stream, line)) {
+    if (line.empty() || line[0] == 'c') continue;
+    graph << line << '\n';
+    if (edges_left == -1) {
+      std::string p, tdp;
+      int N;
+      std::stringstream(line) >> p >> tdp >> N >> edges_left;
+    } else {
+      edges_left--;
+    }
+  }
+  text = graph.str();
+  return edges_left != -1;
+}
+
+// Solves the graphs in the given files, or if there are none, the graphs
+// concatenated on stdin, with the given number of jobs. The decomposition of
+// every graph is written to output_dir, named after its file (with its index
+// if several files have the same name), and a line "fn,treedepth,time,error"
+// per graph (in input order) to csv_fn, or to stdout if that is empty. As the
+// solver state is thread_local, every job simply works on its own graph. If
+// time_limit is positive, every graph gets that many seconds.
+int RunBatch(const std::vector<std::string>& files, int jobs,
+             const std::string& output_dir, const std::string& csv_fn,
+             bool binary_tree, double time_limit) {
+  std::filesystem::create_directories(output_dir);
+  std::mutex mutex;
+
+  // Files with the same name (in different directories) would overwrite each
+  // other's decompositions, so those get their index in the name as well.
+  auto TreeName = [](const std::string& fn) {
+    return fn.substr(0, fn.find_last_of('.'));
+  };
+  std::map<std::string, int> name_count;
+  for (auto& file : files) name_count[TreeName(ExtractFileName(file))]++;
+
+  // The settings of the solver are thread_local, so every job copies ours.
+  auto settings =
+      std::make_tuple(verbose, use_directed_separator_generator,
+                      dfs_tree_threads, symmetry_pruning_deep,
+                      isomorphism_cache_max_vertices);
+  std::vector<std::string> rows;
+  bool failed = false;
+
+  auto job = [&]() {
+    std::tie(verbose, use_directed_separator_generator, dfs_tree_threads,
+             symmetry_pruning_deep, isomorphism_cache_max_vertices) = settings;
+    CancellationToken token;
+    if (time_limit > 0) cancellation_token = &token;
+    while (true) {
+      std::string name, text;
+      size_t index;
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        index = rows.size();
+        if (files.empty()) {
+          if (!ReadNextGraph(std::cin, text)) return;
+          name = "graph_" + std::to_string(index + 1) + ".gr";
+        } else {
+          if (index == files.size()) return;
+          name = files[index];
+        }
+        rows.emplace_back();
+      }
+
+      std::string fn = ExtractFileName(name), error;
+      int td = -1;
+      auto start = std::chrono::steady_clock::now();
+      token.Reset(time_limit);
+      try {
+        if (files.empty()) {
+          LoadGraph(
+              ParseGraph(text.data(), text.data() + text.size()).ToGraph());
+        } else {
+          LoadGraph(ReadGraph(name));
+        }
+        auto [td_graph, tree] = treedepth(full_graph);
+        std::string tree_name = TreeName(fn);
+        auto count = name_count.find(tree_name);
+        if (count != name_count.end() && count->second > 1)
+          tree_name += "_" + std::to_string(index + 1);
+        std::string tree_fn = output_dir + "/" + tree_name + ".tree";
+        WriteTree(tree_fn, td_graph, tree, binary_tree);
+        td = td_graph;
+      } catch (std::exception& e) {
+        error = e.what();
+      }
+      double time_elapsed =
+          0.1 * std::round(10 * std::chrono::duration<double>(
+                                    std::chrono::steady_clock::now() - start)
+                                    .count());
+      std::stringstream row;
+      row << fn << "," << td << "," << time_elapsed << "," << error;
+
+      std::lock_guard<std::mutex> lock(mutex);
+      rows[index] = row.str();
+      if (td == -1) failed = true;
+    }
+  };
+  std::vector<std::thread> threads;
+  for (int j = 0; j < jobs; j++) threads.emplace_back(job);
+  for (auto& thread : threads) thread.join();
+
+  std::ofstream csv_file;
+  if (!csv_fn.empty()) csv_file.open(csv_fn);
+  std::ostream& csv = csv_fn.empty() ? std::cout : csv_file;
+  csv << "fn,treedepth,time,error" << std::endl;
+  for (auto& row : rows) csv << row << std::endl;
+  return failed;
+}
+
+// Writes the trace of the solve to fn, if it was traced.
+void WriteTrace(const std::string& fn) {
+  if (!trace_recorder) return;
+  std::ofstream file(fn);
+  trace_recorder->Write(file);
+  std::cerr << "Wrote " << trace_recorder->events.size()
+            << " trace events to " << fn << " (dropped "
+            << trace_recorder->dropped_events << ")." << std::endl;
+}
+
+#ifdef TDULL_STATS
+// Prints the statistics of the solve as a table to stderr, or as JSON to fn.
+void PrintStats(const std::string& fn) {
+  if (fn.empty()) {
+    STATS_PRINT(std::cerr, false);
+  } else {
+    std::ofstream file(fn);
+    STATS_PRINT(file, true);
+  }
+}
+#endif
+
 int main(int argc, char** argv) {
-  LoadGraph(std::cin);
+  verbose = true;
+  int decide_k = -1;
+  bool batch = false, binary_tree = false;
+  int jobs = 1;
+  std::string output_dir = ".", csv_fn, stats_fn, trace_fn;
+  int trace_depth = 3;
+  int progress_fd = -1;
+  double progress_interval = 10;
+  double time_limit = 0;
+  std::vector<std::string> files;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--decide" && i + 1 < argc) {
+      decide_k = std::stoi(argv[++i]);
+      if (decide_k < 0) {
+        std::cerr << "--decide needs a k of at least 0." << std::endl;
+        return 1;
+      }
+    } else if (arg == "--binary-tree") {
+      binary_tree = true;
+    } else if (arg == "--batch") {
+      batch = true;
+    } else if (arg == "--jobs" && i + 1 < argc) {
+      jobs = std::max(1, std::stoi(argv[++i]));
+    } else if (arg == "--output-dir" && i + 1 < argc) {
+      output_dir = argv[++i];
+    } else if (arg == "--csv" && i + 1 < argc) {
+      csv_fn = argv[++i];
+    } else if (batch && arg.substr(0, 2) != "--") {
+      files.push_back(arg);
+    } else if (arg == "--trace" && i + 1 < argc) {
+      trace_fn = argv[++i];
+    } else if (arg == "--trace-depth" && i + 1 < argc) {
+      trace_depth = std::stoi(argv[++i]);
+    } else if (arg == "--time-limit" && i + 1 < argc) {
+      time_limit = std::stod(argv[++i]);
+    } else if (arg == "--progress" && i + 1 < argc) {
+      progress_fd = open(argv[++i], O_WRONLY | O_CREAT | O_TRUNC, 0644);
+      if (progress_fd < 0) {
+        std::cerr << "Could not open " << argv[i] << "." << std::endl;
+        return 1;
+      }
+    } else if (arg == "--progress-fd" && i + 1 < argc) {
+      progress_fd = std::stoi(argv[++i]);
+    } else if (arg == "--progress-interval" && i + 1 < argc) {
+      progress_interval = std::stod(argv[++i]);
+    } else if (arg == "--directed-separators") {
+      use_directed_separator_generator = true;
+    } else if (arg == "--dfs-tree-threads" && i + 1 < argc) {
+      dfs_tree_threads = std::stoi(argv[++i]);
+#ifdef USE_NAUTY
+    } else if (arg == "--deep-symmetry") {
+      symmetry_pruning_deep = true;
+    } else if (arg == "--isomorphism-cache" && i + 1 < argc) {
+      isomorphism_cache_max_vertices = std::stoi(argv[++i]);
+#endif
+#ifdef TDULL_STATS
+    } else if (arg == "--stats-json" && i + 1 < argc) {
+      stats_fn = argv[++i];
+#endif
+    } else {
+      std::cerr << "Unknown argument \"" << arg << "\"." << std::endl;
+      return 1;
+    }
+  }
+
+  // These report on the single graph being solved, and the solver state is
+  // per thread, so they have no meaning for a batch.
+  if (batch && (decide_k >= 0 || !trace_fn.empty() || progress_fd >= 0 ||
+                !stats_fn.empty())) {
+    std::cerr << "--decide, --trace, --progress(-fd) and --stats-json cannot "
+                 "be combined with --batch."
+              << std::endl;
+    return 1;
+  }
+  if (batch)
+    return RunBatch(files, jobs, output_dir, csv_fn, binary_tree, time_limit);
+
+  ParseStats stats;
+  try {
+    LoadGraph(ReadGraph(STDIN_FILENO, &stats));
+  } catch (std::exception& e) {
+    std::cerr << "Failed! " << e.what() << std::endl;
+    return 1;
+  }
+  std::cerr << "Read " << stats.bytes / 1e6 << " MB in " << stats.seconds
+            << " seconds (" << stats.MegabytesPerSecond() << " MB/s), dropping "
+            << stats.self_loops << " self-loops and " << stats.duplicate_edges
+            << " duplicate edges." << std::endl;
+
+  TraceRecorder recorder(trace_depth);
+  if (!trace_fn.empty()) trace_recorder = &recorder;
+  SolveProgress progress;
+  std::unique_ptr<ProgressReporter> reporter;
+  if (progress_fd >= 0) {
+    solve_progress = &progress;
+    reporter = std::make_unique<ProgressReporter>(progress, progress_fd,
+                                                  progress_interval);
+  }
+
+  CancellationToken token;
+  if (time_limit > 0) {
+    token.Reset(time_limit);
+    cancellation_token = &token;
+  }
 
   auto start = std::chrono::steady_clock::now();
   try {
@@ -42,6 +296,28 @@ int main(int argc, char** argv) {
     //              << double(total_count) / time_elapsed << " seps / s.\n";
     //    return 0;
 
+    if (decide_k > -1) {
+      // Only decide whether td <= k: print YES and a decomposition of depth at
+      // most k, or NO and (as text) a lower bound exceeding k.
+      auto [yes, bound, tree] = treedepth_decide(full_graph, decide_k);
+      double time_elapsed = std::chrono::duration<double>(
+                                std::chrono::steady_clock::now() - start)
+                                .count();
+      std::cerr << "Treedepth is " << (yes ? "at most " : "at least ") << bound
+                << ", took " << time_elapsed << " seconds." << std::endl;
+      if (yes) {
+        std::cout << "YES" << std::endl;
+        WriteTree(STDOUT_FILENO, bound, tree, binary_tree);
+      } else {
+        std::cout << "NO" << std::endl << bound << std::endl;
+      }
+      WriteTrace(trace_fn);
+#ifdef TDULL_STATS
+      PrintStats(stats_fn);
+#endif
+      return 0;
+    }
+
     auto [td, tree] = treedepth(full_graph);
     double time_elapsed =
         0.1 * std::round(10 * std::chrono::duration<double>(
@@ -50,10 +326,13 @@ int main(int argc, char** argv) {
     std::cerr << "Treedepth is: " << td << std::endl;
     std::cerr << "Elapsed time is " << time_elapsed << " seconds.\n";
 
-    std::cout << td << std::endl;
-    for (int parent : tree) std::cout << parent << std::endl;
+    WriteTree(STDOUT_FILENO, td, tree, binary_tree);
 
     std::cerr << td << "," << time_elapsed << ", " << std::endl;
+    WriteTrace(trace_fn);
+#ifdef TDULL_STATS
+    PrintStats(stats_fn);
+#endif
     return 0;
   } catch (std::exception& e) {
     double time_elapsed =
@@ -63,6 +342,10 @@ int main(int argc, char** argv) {
     std::cerr << "Failed! Encountered exception:\"" << e.what() << "\"."
               << std::endl;
     std::cerr << -1 << "," << time_elapsed << "," << e.what() << std::endl;
+    WriteTrace(trace_fn);
+#ifdef TDULL_STATS
+    PrintStats(stats_fn);
+#endif
     return 1;
   }
 }
@@ -8,7 +8,18 @@ extern "C" {
 #include "../third_party/nauty/traces.h"
 }
 
-Nauty::Nauty(const Graph &G) : G(G) {
+// Stores the generators that nauty finds, before passing them on to the
+// group structure.
+thread_local std::vector<std::vector<int>> *global_generators = nullptr;
+void StoreGenerator(int count, int *perm, int *orbits, int numorbits,
+                    int stabvertex, int n) {
+  global_generators->emplace_back(perm, perm + n);
+  groupautomproc(count, perm, orbits, numorbits, stabvertex, n);
+}
+
+// The nauty representation of G. Its arrays are static, so it is only valid
+// until the next call.
+sparsegraph ToSparseGraph(const Graph &G) {
   SG_DECL(sg);
   DYNALLSTAT(size_t, sg_v, sg_v_sz);
   DYNALLSTAT(int, sg_d, sg_d_sz);
@@ -30,6 +41,11 @@ Nauty::Nauty(const Graph &G) : G(G) {
       sg.e[index_e++] = e;
     }
   }
+  return sg;
+}
+
+Nauty::Nauty(const Graph &G) : G(G) {
+  sparsegraph sg = ToSparseGraph(G);
 
   DYNALLSTAT(int, lab, lab_sz);
   DYNALLSTAT(int, ptn, ptn_sz);
@@ -41,9 +57,11 @@ Nauty::Nauty(const Graph &G) : G(G) {
   DEFAULTOPTIONS_SPARSEGRAPH(options);
   statsblk stats;
   // options.getcanon = false;
-  options.userautomproc = groupautomproc;
+  options.userautomproc = StoreGenerator;
   options.userlevelproc = grouplevelproc;
+  global_generators = &generators;
   sparsenauty(&sg, lab, ptn, orbits, &options, &stats, NULL);
+  global_generators = nullptr;
 
   // Store the group structure.
   group = groupptr(true);
@@ -79,10 +97,10 @@ Nauty::Nauty(const Graph &G) : G(G) {
 
 Nauty::~Nauty() { freegroup(group); }
 
-std::vector<std::vector<int>> global_automorphisms;
+thread_local std::vector<std::vector<int>> global_automorphisms;
 void StoreAutomorhphism(int *p, int n) {
   global_automorphisms.emplace_back();
-  global_automorphisms.back().assign(n, *p);
+  global_automorphisms.back().assign(p, p + n);
 }
 
 const std::vector<std::vector<int>> &Nauty::Automorphisms() {
@@ -93,3 +111,34 @@ const std::vector<std::vector<int>> &Nauty::Automorphisms() {
   automorphisms = std::move(global_automorphisms);
   return automorphisms;
 }
+
+CanonicalForm::CanonicalForm(const Graph &G) {
+  sparsegraph sg = ToSparseGraph(G);
+  SG_DECL(canon);
+
+  DYNALLSTAT(int, lab, lab_sz);
+  DYNALLSTAT(int, ptn, ptn_sz);
+  DYNALLSTAT(int, orbits, orbits_sz);
+  DYNALLOC1(int, lab, lab_sz, G.N, "malloc");
+  DYNALLOC1(int, ptn, ptn_sz, G.N, "malloc");
+  DYNALLOC1(int, orbits, orbits_sz, G.N, "malloc");
+
+  DEFAULTOPTIONS_SPARSEGRAPH(options);
+  statsblk stats;
+  options.getcanon = true;
+  sparsenauty(&sg, lab, ptn, orbits, &options, &stats, &canon);
+  sortlists_sg(&canon);
+
+  labelling.assign(lab, lab + G.N);
+  label.resize(G.N);
+  for (int i = 0; i < G.N; i++) label[labelling[i]] = i;
+
+  key.reserve(1 + G.N + 2 * G.M);
+  key.push_back(G.N);
+  for (int i = 0; i < G.N; i++) {
+    key.push_back(canon.d[i]);
+    key.insert(key.end(), canon.e + canon.v[i],
+               canon.e + canon.v[i] + canon.d[i]);
+  }
+  SG_FREE(canon);
+}
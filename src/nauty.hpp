@@ -1,3 +1,5 @@
+#include <cstdint>
+
 #include "graph.hpp"
 
 struct group_struct;
@@ -16,7 +18,36 @@ struct Nauty {
   std::vector<int> orbits;
   std::vector<std::vector<int>> automorphisms;
 
+  // The generators of the automorphism group found by nauty, as permutations
+  // of the local vertices.
+  std::vector<std::vector<int>> generators;
+
  protected:
   const Graph &G;
   group_struct *group = nullptr;
 };
+
+// A canonical labelling of G, computed by nauty. Isomorphic graphs get the
+// same key, which encodes the relabelled graph.
+struct CanonicalForm {
+  CanonicalForm(const Graph &G);
+
+  // The local vertex that gets canonical label i, and the inverse.
+  std::vector<int> labelling;
+  std::vector<int> label;
+
+  // [N, deg(0), N(0)..., deg(1), N(1)..., ...] in the canonical labels, with
+  // sorted neighborhoods.
+  std::vector<int> key;
+
+  struct Hash {
+    size_t operator()(const std::vector<int> &key) const {
+      uint64_t h = key.size();
+      for (int x : key) {
+        h = (h ^ uint64_t(x)) * 0x9e3779b97f4a7c15ULL;
+        h ^= h >> 29;
+      }
+      return h;
+    }
+  };
+};
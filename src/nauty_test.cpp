@@ -27,6 +27,13 @@ int main() {
   assert(nauty_line_6.num_orbits == 3);
   assert(nauty_line_6.orbit_representatives.size() == nauty_line_6.num_orbits);
   assert(nauty_line_6.orbit_representatives == (std::vector<int>{0, 1, 2}));
+  assert(nauty_line_6.generators ==
+         (std::vector<std::vector<int>>{{5, 4, 3, 2, 1, 0}}));
+  std::vector<std::vector<int>> line_6_automorphisms =
+      nauty_line_6.automorphisms;
+  std::sort(line_6_automorphisms.begin(), line_6_automorphisms.end());
+  assert(line_6_automorphisms == (std::vector<std::vector<int>>{
+                                     {0, 1, 2, 3, 4, 5}, {5, 4, 3, 2, 1, 0}}));
 
   std::istringstream bla("p tdp 4 4 1 2 2 3 3 1 1 4");
   LoadGraph(bla);
@@ -38,5 +45,25 @@ int main() {
   assert(nauty_bla.orbit_representatives.size() == nauty_bla.num_orbits);
   assert(nauty_bla.orbit_representatives == (std::vector<int>{0, 1, 3}));
 
+  // Isomorphic graphs have the same canonical form, and the labellings
+  // translate between them.
+  std::istringstream paw_1("p tdp 4 4 1 2 2 3 3 1 1 4");
+  LoadGraph(paw_1);
+  Graph G_paw_1 = full_graph;
+  CanonicalForm canon_paw_1(G_paw_1);
+  std::istringstream paw_2("p tdp 4 4 4 3 3 2 2 4 2 1");
+  LoadGraph(paw_2);
+  Graph G_paw_2 = full_graph;
+  CanonicalForm canon_paw_2(G_paw_2);
+  assert(canon_paw_1.key == canon_paw_2.key);
+  for (int i = 0; i < 4; i++) {
+    assert(canon_paw_1.label[canon_paw_1.labelling[i]] == i);
+    assert(G_paw_1.Adj(canon_paw_1.labelling[i]).size() ==
+           G_paw_2.Adj(canon_paw_2.labelling[i]).size());
+  }
+  std::istringstream star_4("p tdp 4 3 1 2 1 3 1 4");
+  LoadGraph(star_4);
+  assert(CanonicalForm(full_graph).key != canon_paw_1.key);
+
   return 0;
 }
@@ -0,0 +1,120 @@
+#pragma once
+// Periodic progress reports of a long solve, for a job scheduler that wants
+// to kill hopeless runs early. The solver thread publishes its progress in a
+// SolveProgress (if solve_progress points to one), with relaxed stores that
+// only it writes, and a ProgressReporter reads it from its own thread and
+// writes a JSON line every interval seconds. The solver never waits on the
+// reporter.
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
+struct SolveProgress {
+  std::atomic<int> lower{-1}, upper{-1};
+  std::atomic<size_t> cache_size{0}, separators_generated{0};
+
+  void SetBounds(int lower, int upper) {
+    this->lower.store(lower, std::memory_order_relaxed);
+    this->upper.store(upper, std::memory_order_relaxed);
+  }
+  void AddSeparators(size_t count) {
+    separators_generated.store(
+        separators_generated.load(std::memory_order_relaxed) + count,
+        std::memory_order_relaxed);
+  }
+};
+
+// The progress of the solve on this thread, if it is reported.
+inline thread_local SolveProgress *solve_progress = nullptr;
+
+// The resident set size of this process in bytes, 0 if unknown.
+inline size_t ResidentSetSize() {
+  std::ifstream statm("/proc/self/statm");
+  size_t pages = 0, resident = 0;
+  statm >> pages >> resident;
+  return resident * sysconf(_SC_PAGESIZE);
+}
+
+// Writes a line
+//   {"elapsed": 12.0, "lower": 10, "upper": 14, "cache_size": 1234,
+//    "separators": 56789, "separators_per_second": 4567.8, "rss_mb": 12.3}
+// to fd every interval seconds, and a last one (with "done": true) when it is
+// stopped or destroyed.
+class ProgressReporter {
+ public:
+  ProgressReporter(const SolveProgress &progress, int fd, double interval)
+      : progress(progress),
+        fd(fd),
+        interval(interval),
+        start(std::chrono::steady_clock::now()),
+        thread([this] { Run(); }) {}
+  ~ProgressReporter() { Stop(); }
+
+  void Stop() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (stopped) return;
+      stopped = true;
+    }
+    stop.notify_one();
+    thread.join();
+    Report(true);
+  }
+
+ private:
+  const SolveProgress &progress;
+  const int fd;
+  const double interval;
+  const std::chrono::steady_clock::time_point start;
+  double last_elapsed = 0;
+  size_t last_separators = 0;
+
+  std::mutex mutex;
+  std::condition_variable stop;
+  bool stopped = false;
+  std::thread thread;
+
+  void Run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    auto next = start;
+    while (true) {
+      next += std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+          std::chrono::duration<double>(interval));
+      if (stop.wait_until(lock, next, [this] { return stopped; })) return;
+      Report(false);
+    }
+  }
+
+  void Report(bool done) {
+    double elapsed = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+    size_t separators =
+        progress.separators_generated.load(std::memory_order_relaxed);
+    double per_second = elapsed > last_elapsed
+                            ? (separators - last_separators) /
+                                  (elapsed - last_elapsed)
+                            : 0;
+    last_elapsed = elapsed;
+    last_separators = separators;
+
+    char line[512];
+    int length = snprintf(
+        line, sizeof(line),
+        "{\"elapsed\": %.1f, \"lower\": %d, \"upper\": %d, \"cache_size\": "
+        "%zu, \"separators\": %zu, \"separators_per_second\": %.1f, "
+        "\"rss_mb\": %.1f%s}\n",
+        elapsed, progress.lower.load(std::memory_order_relaxed),
+        progress.upper.load(std::memory_order_relaxed),
+        progress.cache_size.load(std::memory_order_relaxed), separators,
+        per_second, ResidentSetSize() / 1e6, done ? ", \"done\": true" : "");
+    // A failed write only loses a report, which is not worth stopping for.
+    if (write(fd, line, length) < 0) return;
+  }
+};
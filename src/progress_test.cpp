@@ -0,0 +1,64 @@
+#include "progress.hpp"
+
+// The checks must run in the release build as well.
+#undef NDEBUG
+#include <cassert>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "treedepth.hpp"
+
+// Reads everything that is left in the pipe.
+std::string ReadAll(int fd) {
+  std::string result;
+  char buffer[4096];
+  ssize_t length;
+  while ((length = read(fd, buffer, sizeof(buffer))) > 0)
+    result.append(buffer, length);
+  return result;
+}
+
+int main() {
+  // Reports while the progress changes, and a last one when stopped.
+  {
+    int fds[2];
+    if (pipe(fds) != 0) return 1;
+    SolveProgress progress;
+    ProgressReporter reporter(progress, fds[1], 0.05);
+    progress.SetBounds(3, 7);
+    progress.AddSeparators(100);
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    progress.SetBounds(5, 5);
+    reporter.Stop();
+    close(fds[1]);
+    std::string output = ReadAll(fds[0]);
+    close(fds[0]);
+    std::cout << output;
+    std::stringstream lines(output);
+    std::string line, last;
+    int count = 0;
+    while (std::getline(lines, line)) {
+      assert(line.front() == '{' && line.back() == '}');
+      last = line;
+      count++;
+    }
+    assert(count >= 2);
+    assert(last.find("\"lower\": 5, \"upper\": 5") != std::string::npos);
+    assert(last.find("\"separators\": 100") != std::string::npos);
+    assert(last.find("\"done\": true") != std::string::npos);
+  }
+
+  // The solver publishes its bounds and cache size.
+  {
+    std::stringstream stream(
+        "p tdp 6 7\n1 2\n2 3\n3 4\n4 5\n5 6\n6 1\n1 4\n");
+    LoadGraph(stream);
+    SolveProgress progress;
+    solve_progress = &progress;
+    auto [td, tree] = treedepth(full_graph);
+    solve_progress = nullptr;
+    assert(progress.lower == td && progress.upper == td);
+  }
+  return 0;
+}
@@ -0,0 +1,410 @@
+// End-to-end regression benchmark: runs the solver on a list of instances, in
+// separate processes, and compares the results to a baseline. Usage:
+//   ./regression [--instances FILE] [--solver PATH] [--timeout SECONDS]
+//                [--repetitions R] [--jobs J] [--verify] [--stats]
+//                [--output FILE] [--baseline FILE] [--threshold FRACTION]
+//                [--min-difference SECONDS] [INSTANCES...]
+// The instances file has a graph per line (# starts a comment). Every
+// instance is solved R times, by at most J solver processes at once (note
+// that these disturb each other's timings). A run gets --time-limit TIMEOUT,
+// and is killed if it does not stop within a few seconds after that.
+//
+// For every run, the output (a CSV) gets its wall time, peak RSS, treedepth
+// (from the decomposition), whether the decomposition is valid (with
+// --verify), and with --stats the instrumentation counters of a solver built
+// with `make STATS=1`. The baseline is the output of an earlier run. An
+// instance regresses if its treedepth changed, it no longer gets solved, or
+// its median time grew by more than the threshold (default 10%) and by more
+// than min-difference seconds (default 0.5), to ignore noise. The exit code
+// is 1 if there are regressions.
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct Run {
+  std::string fn;
+  int repetition = 0;
+  int treedepth = -1;
+  double time = 0;
+  double rss_mb = 0;
+  std::string error;
+  std::vector<std::pair<std::string, double>> counters;
+};
+
+std::string ExtractFileName(const std::string& str) {
+  return str.substr(str.find_last_of("/") + 1);
+}
+
+// Runs argv[0] with the given arguments, stdin, stdout and stderr. Kills it
+// after timeout seconds. Returns its exit status (as given by wait4), its
+// wall time and its resource usage.
+int Execute(const std::vector<std::string>& args, const std::string& in_fn,
+            const std::string& out_fn, const std::string& err_fn,
+            double timeout, double& time, rusage& usage) {
+  std::vector<char*> argv;
+  for (auto& arg : args) argv.push_back(const_cast<char*>(arg.c_str()));
+  argv.push_back(nullptr);
+
+  auto start = std::chrono::steady_clock::now();
+  pid_t pid = fork();
+  if (pid == 0) {
+    int in = open(in_fn.c_str(), O_RDONLY);
+    int out = open(out_fn.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    int err = open(err_fn.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (in < 0 || out < 0 || err < 0) _exit(127);
+    dup2(in, STDIN_FILENO);
+    dup2(out, STDOUT_FILENO);
+    dup2(err, STDERR_FILENO);
+    execv(argv[0], argv.data());
+    _exit(127);
+  }
+  if (pid < 0) throw std::runtime_error("Could not fork.");
+
+  int status = 0;
+  auto deadline = start + std::chrono::duration_cast<
+                              std::chrono::steady_clock::duration>(
+                              std::chrono::duration<double>(timeout));
+  while (wait4(pid, &status, WNOHANG, &usage) == 0) {
+    if (std::chrono::steady_clock::now() > deadline) {
+      kill(pid, SIGKILL);
+      wait4(pid, &status, 0, &usage);
+      break;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  time = std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+             .count();
+  return status;
+}
+
+// Reads the "name": number pairs of a flat JSON object (skipping arrays).
+std::vector<std::pair<std::string, double>> ReadCounters(
+    const std::string& fn) {
+  std::ifstream file(fn);
+  std::vector<std::pair<std::string, double>> counters;
+  std::string line;
+  while (std::getline(file, line)) {
+    size_t open_quote = line.find('"'), close_quote = line.rfind('"');
+    size_t colon = line.find(':', close_quote);
+    if (open_quote == std::string::npos || colon == std::string::npos ||
+        line.find('[') != std::string::npos)
+      continue;
+    try {
+      counters.emplace_back(
+          line.substr(open_quote + 1, close_quote - open_quote - 1),
+          std::stod(line.substr(colon + 1)));
+    } catch (std::exception& e) {
+    }
+  }
+  return counters;
+}
+
+// The last line of the file that contains pattern, or "" if there is none.
+std::string FindLine(const std::string& fn, const std::string& pattern) {
+  std::ifstream file(fn);
+  std::string line, result;
+  while (std::getline(file, line))
+    if (line.find(pattern) != std::string::npos) result = line;
+  return result;
+}
+
+struct Options {
+  std::string solver = "./main", verifier = "./verify";
+  double timeout = 1800;
+  bool verify = false, stats = false;
+  std::string work_dir;
+};
+
+Run SolveInstance(const std::string& fn, int repetition,
+                  const Options& options) {
+  Run run;
+  run.fn = fn;
+  run.repetition = repetition;
+  std::string base = options.work_dir + "/" + ExtractFileName(fn) + "." +
+                     std::to_string(repetition);
+  std::vector<std::string> args = {options.solver, "--time-limit",
+                                   std::to_string(options.timeout)};
+  if (options.stats) {
+    args.push_back("--stats-json");
+    args.push_back(base + ".json");
+  }
+
+  // The solver stops itself at the time limit, so it is only killed if that
+  // somehow fails.
+  rusage usage;
+  int status = Execute(args, fn, base + ".tree", base + ".err",
+                       options.timeout + 5, run.time, usage);
+  run.rss_mb = usage.ru_maxrss / 1e3;
+
+  if (WIFEXITED(status) && WEXITSTATUS(status) == 0) {
+    std::ifstream tree(base + ".tree");
+    if (!(tree >> run.treedepth)) run.error = "No decomposition.";
+  } else if (WIFSIGNALED(status)) {
+    run.error = "Killed by signal " + std::to_string(WTERMSIG(status)) + ".";
+  } else {
+    run.error = FindLine(base + ".err", "Failed!");
+    run.error.erase(0, run.error.find("Failed!"));
+    if (run.error.empty())
+      run.error = "Exit status " + std::to_string(WEXITSTATUS(status)) + ".";
+  }
+
+  if (run.treedepth > -1 && options.verify) {
+    double time;
+    int verify_status = Execute({options.verifier, fn, base + ".tree"},
+                                "/dev/null", base + ".verify", base + ".verify",
+                                options.timeout, time, usage);
+    if (!WIFEXITED(verify_status) || WEXITSTATUS(verify_status) != 0) {
+      run.error = "Invalid decomposition.";
+      run.treedepth = -1;
+    }
+  }
+  if (options.stats) run.counters = ReadCounters(base + ".json");
+
+  for (auto ext : {".tree", ".err", ".json", ".verify"})
+    std::filesystem::remove(base + ext);
+  return run;
+}
+
+void WriteRuns(std::ostream& csv, const std::vector<Run>& runs) {
+  csv << "fn,repetition,treedepth,time,rss_mb,error";
+  if (runs.size())
+    for (auto& [name, value] : runs[0].counters) csv << "," << name;
+  csv << std::endl;
+  for (auto& run : runs) {
+    // The error is a free text, which must not break the columns.
+    std::string error = run.error;
+    std::replace(error.begin(), error.end(), ',', ';');
+    csv << run.fn << "," << run.repetition << "," << run.treedepth << ","
+        << run.time << "," << run.rss_mb << "," << error;
+    for (auto& [name, value] : run.counters) csv << "," << value;
+    csv << std::endl;
+  }
+}
+
+std::vector<Run> ReadRuns(const std::string& fn) {
+  std::ifstream csv(fn);
+  if (!csv) throw std::runtime_error("Could not read " + fn + ".");
+  std::vector<Run> runs;
+  std::string line;
+  std::getline(csv, line);
+  while (std::getline(csv, line)) {
+    std::stringstream stream(line);
+    std::vector<std::string> cols;
+    std::string col;
+    while (std::getline(stream, col, ',')) cols.push_back(col);
+    if (cols.size() < 5) continue;
+    Run run;
+    run.fn = cols[0];
+    run.repetition = std::stoi(cols[1]);
+    run.treedepth = std::stoi(cols[2]);
+    run.time = std::stod(cols[3]);
+    run.rss_mb = std::stod(cols[4]);
+    if (cols.size() > 5) run.error = cols[5];
+    runs.push_back(run);
+  }
+  return runs;
+}
+
+// The summary of the repetitions of an instance.
+struct Summary {
+  int treedepth = -1;  // -1 if any of the repetitions failed.
+  double time = 0;     // Median.
+  double rss_mb = 0;   // Maximum.
+};
+
+std::map<std::string, Summary> Summarize(const std::vector<Run>& runs) {
+  std::map<std::string, std::vector<const Run*>> instances;
+  for (auto& run : runs) instances[ExtractFileName(run.fn)].push_back(&run);
+  std::map<std::string, Summary> result;
+  for (auto& [name, instance_runs] : instances) {
+    Summary& summary = result[name];
+    summary.treedepth = instance_runs[0]->treedepth;
+    std::vector<double> times;
+    for (auto* run : instance_runs) {
+      if (run->treedepth == -1) summary.treedepth = -1;
+      times.push_back(run->time);
+      summary.rss_mb = std::max(summary.rss_mb, run->rss_mb);
+    }
+    std::sort(times.begin(), times.end());
+    size_t middle = times.size() / 2;
+    summary.time = times.size() % 2 ? times[middle]
+                                    : (times[middle - 1] + times[middle]) / 2;
+  }
+  return result;
+}
+
+// Prints the comparison of every instance to the baseline, and returns the
+// number of regressions.
+int Compare(const std::map<std::string, Summary>& current,
+            const std::map<std::string, Summary>& baseline, double threshold,
+            double min_difference) {
+  int regressions = 0, improvements = 0;
+  double total_time = 0, total_time_baseline = 0;
+  std::cout << std::left << std::setw(20) << "instance" << std::right
+            << std::setw(6) << "td" << std::setw(10) << "time"
+            << std::setw(10) << "baseline" << std::setw(8) << "ratio"
+            << std::setw(10) << "rss_mb" << std::endl;
+  for (auto& [name, summary] : current) {
+    std::cout << std::left << std::setw(20) << name << std::right
+              << std::setw(6) << summary.treedepth << std::setw(10)
+              << std::fixed << std::setprecision(2) << summary.time;
+    auto it = baseline.find(name);
+    std::string verdict;
+    if (it == baseline.end()) {
+      std::cout << std::setw(10) << "-" << std::setw(8) << "-";
+    } else {
+      const Summary& base = it->second;
+      double ratio = summary.time / std::max(base.time, 1e-3);
+      std::cout << std::setw(10) << base.time << std::setw(8) << ratio;
+      bool slower = summary.time > base.time * (1 + threshold) &&
+                    summary.time - base.time > min_difference;
+      bool faster = base.time > summary.time * (1 + threshold) &&
+                    base.time - summary.time > min_difference;
+      if (base.treedepth > -1 && summary.treedepth > -1 &&
+          base.treedepth != summary.treedepth) {
+        verdict = "REGRESSION: treedepth was " +
+                  std::to_string(base.treedepth);
+      } else if (base.treedepth > -1 && summary.treedepth == -1) {
+        verdict = "REGRESSION: no longer solved";
+      } else if (base.treedepth == -1 && summary.treedepth > -1) {
+        verdict = "newly solved";
+        improvements++;
+      } else if (summary.treedepth > -1 && slower) {
+        verdict = "REGRESSION: slower";
+      } else if (summary.treedepth > -1 && faster) {
+        verdict = "faster";
+        improvements++;
+      }
+      if (verdict.rfind("REGRESSION", 0) == 0) regressions++;
+      if (base.treedepth > -1 && summary.treedepth > -1) {
+        total_time += summary.time;
+        total_time_baseline += base.time;
+      }
+    }
+    std::cout << std::setw(10) << summary.rss_mb << "  " << verdict
+              << std::endl;
+  }
+  std::cout << std::defaultfloat;
+  if (baseline.size())
+    std::cout << "On the instances solved by both, the total time went from "
+              << total_time_baseline << " to " << total_time << " seconds. "
+              << regressions << " regressions, " << improvements
+              << " improvements." << std::endl;
+  return regressions;
+}
+
+int main(int argc, char** argv) {
+  Options options;
+  int repetitions = 1, jobs = 1;
+  double threshold = 0.1, min_difference = 0.5;
+  std::string output_fn, baseline_fn;
+  std::vector<std::string> instances;
+  auto read_instances = [&](const std::string& fn) {
+    std::ifstream file(fn);
+    if (!file) throw std::runtime_error("Could not read " + fn + ".");
+    std::string line;
+    while (std::getline(file, line)) {
+      line = line.substr(0, line.find('#'));
+      line.erase(0, line.find_first_not_of(" \t"));
+      line.erase(line.find_last_not_of(" \t\r") + 1);
+      if (line.size()) instances.push_back(line);
+    }
+  };
+
+  try {
+    for (int i = 1; i < argc; i++) {
+      std::string arg = argv[i];
+      if (arg == "--instances" && i + 1 < argc) {
+        read_instances(argv[++i]);
+      } else if (arg == "--solver" && i + 1 < argc) {
+        options.solver = argv[++i];
+      } else if (arg == "--verifier" && i + 1 < argc) {
+        options.verifier = argv[++i];
+      } else if (arg == "--timeout" && i + 1 < argc) {
+        options.timeout = std::stod(argv[++i]);
+      } else if (arg == "--repetitions" && i + 1 < argc) {
+        repetitions = std::max(1, std::stoi(argv[++i]));
+      } else if (arg == "--jobs" && i + 1 < argc) {
+        jobs = std::max(1, std::stoi(argv[++i]));
+      } else if (arg == "--verify") {
+        options.verify = true;
+      } else if (arg == "--stats") {
+        options.stats = true;
+      } else if (arg == "--output" && i + 1 < argc) {
+        output_fn = argv[++i];
+      } else if (arg == "--baseline" && i + 1 < argc) {
+        baseline_fn = argv[++i];
+      } else if (arg == "--threshold" && i + 1 < argc) {
+        threshold = std::stod(argv[++i]);
+      } else if (arg == "--min-difference" && i + 1 < argc) {
+        min_difference = std::stod(argv[++i]);
+      } else if (arg.substr(0, 2) != "--") {
+        instances.push_back(arg);
+      } else {
+        std::cerr << "Unknown argument \"" << arg << "\"." << std::endl;
+        return 1;
+      }
+    }
+  } catch (std::exception& e) {
+    std::cerr << "Failed! " << e.what() << std::endl;
+    return 1;
+  }
+
+  options.work_dir = (std::filesystem::temp_directory_path() /
+                      ("tdull_regression_" + std::to_string(getpid())))
+                         .string();
+  std::filesystem::create_directories(options.work_dir);
+
+  // Every job takes the next run, round-robin over the instances so that the
+  // repetitions of an instance do not run at the same time.
+  std::vector<Run> runs(instances.size() * repetitions);
+  std::atomic<size_t> next = 0;
+  auto job = [&]() {
+    for (size_t r; (r = next++) < runs.size();) {
+      int repetition = r / instances.size();
+      const std::string& fn = instances[r % instances.size()];
+      runs[r] = SolveInstance(fn, repetition, options);
+      std::cerr << ExtractFileName(fn) << " (" << repetition + 1 << "/"
+                << repetitions << "): treedepth " << runs[r].treedepth
+                << ", " << runs[r].time << " seconds, " << runs[r].rss_mb
+                << " MB. " << runs[r].error << std::endl;
+    }
+  };
+  std::vector<std::thread> threads;
+  for (int j = 0; j < jobs; j++) threads.emplace_back(job);
+  for (auto& thread : threads) thread.join();
+  std::filesystem::remove_all(options.work_dir);
+
+  if (!output_fn.empty()) {
+    std::ofstream csv(output_fn);
+    WriteRuns(csv, runs);
+  }
+
+  std::map<std::string, Summary> baseline;
+  if (!baseline_fn.empty()) {
+    try {
+      baseline = Summarize(ReadRuns(baseline_fn));
+    } catch (std::exception& e) {
+      std::cerr << "Failed! " << e.what() << std::endl;
+      return 1;
+    }
+  }
+  return Compare(Summarize(runs), baseline, threshold, min_difference) > 0;
+}
@@ -1,6 +1,9 @@
 #include "separator.hpp"
 
 #include <cassert>
+#include <stdexcept>
+
+#include "cancellation.hpp"
 
 // Initializes a separator of G. This checks whether or not the separator
 // of G given by the vertices is "truly minimal": it contains no separator
@@ -12,7 +15,7 @@
 Separator::Separator(const Graph &G, const std::vector<int> &vertices)
     : vertices(vertices), fully_minimal(true) {
   // Shared datastructure.
-  static std::stack<int> component;
+  thread_local std::stack<int> component;
 
   std::vector<bool> visited(G.N, false);
   std::vector<bool> in_sep(G.N, false);
@@ -69,12 +72,328 @@ Separator::Separator(const Graph &G, const std::vector<int> &vertices)
   if (num_components == 1) fully_minimal = false;
 }
 
-SeparatorGenerator::SeparatorGenerator(const Graph &G)
-    : G(G), in_nbh(G.N, false), sep_mask(G.N) {
+// Advances the timestamp, resetting the marks once it wraps around.
+inline void NextStamp(std::vector<uint32_t> &marks, uint32_t &stamp) {
+  if (++stamp == 0) {
+    std::fill(marks.begin(), marks.end(), 0);
+    stamp = 1;
+  }
+}
+
+bool FullyMinimalChecker::Check(const std::vector<int> &separator,
+                                const std::vector<int> &component,
+                                int component_M,
+                                std::pair<int, int> &largest_component) {
+  // There has to be a second component.
+  assert(component.size());
+  if (separator.size() + component.size() == G.N) return false;
+
+  NextStamp(sep_mark, stamp);
+  if (stamp == 1) std::fill(visit_mark.begin(), visit_mark.end(), 0);
+  for (int s : separator) sep_mark[s] = stamp;
+  for (int v : component) visit_mark[v] = stamp;
+
+  // Single leaves are not counted as components here, see Separator.
+  largest_component = {0, 0};
+  if (component.size() > 1 || G.Adj(component[0]).size() > 1)
+    largest_component = {int(component.size()), component_M / 2};
+
+  // As G is connected, every other component is adjacent to the separator.
+  for (int s : separator)
+    for (int v : G.Adj(s)) {
+      if (sep_mark[v] == stamp || visit_mark[v] == stamp) continue;
+      visit_mark[v] = stamp;
+      if (G.Adj(v).size() == 1) continue;
+
+      NextStamp(touch_mark, touch_stamp);
+      int comp_N = 1, comp_M = 0, touched = 0;
+      assert(stack.empty());
+      stack.push_back(v);
+      while (stack.size()) {
+        int cur = stack.back();
+        stack.pop_back();
+        for (int nb : G.Adj(cur)) {
+          if (sep_mark[nb] == stamp) {
+            if (touch_mark[nb] != touch_stamp) {
+              touch_mark[nb] = touch_stamp;
+              touched++;
+            }
+          } else {
+            comp_M++;
+            if (visit_mark[nb] != stamp) {
+              visit_mark[nb] = stamp;
+              comp_N++;
+              stack.push_back(nb);
+            }
+          }
+        }
+      }
+      if (touched < separator.size()) return false;
+      largest_component = std::max(largest_component, {comp_N, comp_M / 2});
+    }
+  return true;
+}
+
+bool SeparatorOrbits::Expand(const std::vector<int> &separator) {
+  if (!expanded.Insert(separator)) return false;
+
+  // Mark the images of the separator, breadth first.
+  orbit.assign(1, separator);
+  for (size_t i = 0; i < orbit.size() && orbit.size() < max_orbit_size; i++)
+    for (const auto &generator : generators) {
+      std::vector<int> image;
+      image.reserve(separator.size());
+      for (int v : orbit[i]) image.push_back(generator[v]);
+      if (expanded.Insert(image))
+        orbit.emplace_back(std::move(image));
+      if (orbit.size() >= max_orbit_size) break;
+    }
+  return true;
+}
+
+inline void PutVarint(std::vector<uint8_t> &out, uint32_t x) {
+  while (x >= 0x80) {
+    out.push_back(uint8_t(x) | 0x80);
+    x >>= 7;
+  }
+  out.push_back(uint8_t(x));
+}
+
+inline uint32_t GetVarint(const uint8_t *&in) {
+  uint32_t x = 0;
+  for (int shift = 0;; shift += 7) {
+    uint8_t byte = *in++;
+    x |= uint32_t(byte & 0x7f) << shift;
+    if (byte < 0x80) return x;
+  }
+}
+
+bool SeparatorSet::Insert(const std::vector<int> &vertices) {
+  thread_local std::vector<int> sorted;
+  sorted.assign(vertices.begin(), vertices.end());
+  std::sort(sorted.begin(), sorted.end());
+  auto [it, inserted] =
+      index_.emplace(SeparatorFingerprint(sorted).value, sets_.size());
+  if (inserted) {
+    PutVarint(sets_, sorted.size());
+    int prev = 0;
+    for (int v : sorted) PutVarint(sets_, v - prev), prev = v;
+    return true;
+  }
+
+  // Most lookups are hits, so this must be cheap: decode the stored set, and
+  // compare it to the sorted one.
+  const uint8_t *in = sets_.data() + it->second;
+  bool equal = GetVarint(in) == sorted.size();
+  int prev = 0;
+  for (int i = 0; equal && i < sorted.size(); i++)
+    equal = (prev += GetVarint(in)) == sorted[i];
+  if (equal) return false;
+  return collisions_.insert(sorted).second;
+}
+
+void SeparatorSet::clear() {
+  index_.clear();
+  sets_.clear();
+  collisions_.clear();
+}
+
+SeparatorQueue::~SeparatorQueue() {
+  if (spill_) std::fclose(spill_);
+}
+
+void SeparatorQueue::push(const std::vector<int> &vertices) {
+  thread_local std::vector<int> sorted;
+  thread_local std::vector<uint8_t> encoded;
+  sorted.assign(vertices.begin(), vertices.end());
+  std::sort(sorted.begin(), sorted.end());
+
+  size_++;
+
+  // Once something is on disk, everything after it must go there as well.
+  if (spill_size_ == 0 && memory_.size() - memory_head_ < max_memory_) {
+    PutVarint(memory_, sorted.size());
+    int prev = 0;
+    for (int v : sorted) PutVarint(memory_, v - prev), prev = v;
+    return;
+  }
+
+  encoded.clear();
+  PutVarint(encoded, sorted.size());
+  int prev = 0;
+  for (int v : sorted) PutVarint(encoded, v - prev), prev = v;
+
+  if (spill_ == nullptr) {
+    spill_ = std::tmpfile();
+    if (spill_ == nullptr)
+      throw std::runtime_error("Could not create a separator spill file.");
+  }
+  uint32_t num_bytes = encoded.size();
+  std::fseek(spill_, spill_write_, SEEK_SET);
+  if (std::fwrite(&num_bytes, sizeof(num_bytes), 1, spill_) != 1 ||
+      std::fwrite(encoded.data(), 1, num_bytes, spill_) != num_bytes)
+    throw std::runtime_error("Could not write the separator spill file.");
+  spill_write_ += sizeof(num_bytes) + num_bytes;
+  spill_size_++;
+  spilled_++;
+}
+
+void SeparatorQueue::Unspill() {
+  assert(memory_head_ == memory_.size() && spill_size_);
+  memory_.clear();
+  memory_head_ = 0;
+
+  // Read back up to half of the memory budget.
+  std::fseek(spill_, spill_read_, SEEK_SET);
+  while (spill_size_ && memory_.size() <= max_memory_ / 2) {
+    uint32_t num_bytes;
+    if (std::fread(&num_bytes, sizeof(num_bytes), 1, spill_) != 1)
+      throw std::runtime_error("Could not read the separator spill file.");
+    memory_.resize(memory_.size() + num_bytes);
+    if (std::fread(memory_.data() + memory_.size() - num_bytes, 1, num_bytes,
+                   spill_) != num_bytes)
+      throw std::runtime_error("Could not read the separator spill file.");
+    spill_read_ += sizeof(num_bytes) + num_bytes;
+    spill_size_--;
+  }
+
+  // If the file has been read completely, we can start over.
+  if (spill_size_ == 0) spill_read_ = spill_write_ = 0;
+}
+
+void SeparatorQueue::pop(std::vector<int> &vertices) {
+  assert(size_);
+  if (memory_head_ == memory_.size()) Unspill();
+  const uint8_t *in = memory_.data() + memory_head_;
+  vertices.resize(GetVarint(in));
+  int prev = 0;
+  for (int &v : vertices) v = prev += GetVarint(in);
+  memory_head_ = in - memory_.data();
+  size_--;
+
+  // Compact the buffer once the consumed part dominates.
+  if (memory_head_ == memory_.size()) {
+    memory_.clear();
+    memory_head_ = 0;
+  } else if (memory_head_ > (size_t(1) << 16) &&
+             2 * memory_head_ > memory_.size()) {
+    memory_.erase(memory_.begin(), memory_.begin() + memory_head_);
+    memory_head_ = 0;
+  }
+}
+
+void SeparatorQueue::clear() {
+  memory_.clear();
+  memory_head_ = 0;
+  size_ = spill_size_ = 0;
+  spill_read_ = spill_write_ = 0;
+}
+
+void SeparatorGenerator::Enqueue(const std::vector<int> &separator,
+                                 const std::vector<int> &component,
+                                 int component_M) {
+  if (!MarkDone(separator)) return;
+
+  queue.push(separator);
+  std::pair<int, int> largest_component;
+  if (checker.Check(separator, component, component_M, largest_component))
+    buffer.emplace_back(separator, largest_component);
+}
+
+SeparatorGenerator::SeparatorGenerator(const Graph &G,
+                                       size_t max_queue_memory)
+    : G(G), queue(max_queue_memory), in_nbh(G.N, false), checker(G) {
+  SeedVertices();
+}
+
+std::vector<Separator> SeparatorsFromSeeds(
+    const Graph &G, const std::vector<std::vector<int>> &seeds) {
   // Datatypes that will be reused.
-  static std::stack<int> component;
-  static std::vector<int> separator;
-  static std::vector<int> neighborhood;
+  thread_local std::stack<int> component;
+  thread_local std::vector<int> seed;
+  thread_local std::vector<int> separator;
+
+  // Map the global coordinates of G to local ones.
+  auto &local_index = full_graph_index;
+  if (local_index.size() < full_graph_mask.size())
+    local_index.resize(full_graph_mask.size(), -1);
+  for (int v = 0; v < G.N; v++) local_index[G.global[v]] = v;
+
+  // Translate the seeds up front, so that local_index is reset again before
+  // the loop below can be cancelled.
+  std::vector<std::vector<int>> local_seeds;
+  for (const auto &seed_global : seeds) {
+    seed.clear();
+    for (int v_glob : seed_global)
+      if (v_glob < local_index.size() && local_index[v_glob] > -1)
+        seed.push_back(local_index[v_glob]);
+    if (seed.empty() || seed.size() + 1 >= G.N) continue;
+    local_seeds.push_back(seed);
+  }
+  for (int v = 0; v < G.N; v++) local_index[G.global[v]] = -1;
+
+  // A seed X need not be a separator of G at all. However, for every
+  // component H of G \ X, the set N(H) is contained in X, and those sets that
+  // turn out to be fully minimal separators of G are exactly what we want.
+  std::vector<Separator> result;
+  std::vector<bool> visited(G.N, false);
+  std::vector<bool> in_seed(G.N, false);
+  for (const auto &seed : local_seeds) {
+    CheckCancelled(G.N + G.M);
+    for (int v : seed) in_seed[v] = true;
+    for (int j = 0; j < G.N; j++) {
+      if (in_seed[j] || visited[j]) continue;
+
+      assert(component.empty());
+      separator.clear();
+      component.push(j);
+      visited[j] = true;
+      while (!component.empty()) {
+        int cur = component.top();
+        component.pop();
+        for (int nb : G.Adj(cur)) {
+          if (!visited[nb]) {
+            if (in_seed[nb]) {
+              separator.push_back(nb);
+            } else {
+              component.push(nb);
+            }
+            visited[nb] = true;
+          }
+        }
+      }
+      for (int v : seed) visited[v] = false;
+
+      Separator sep(G, separator);
+      if (sep.fully_minimal) result.emplace_back(std::move(sep));
+    }
+    for (int j = 0; j < G.N; j++) visited[j] = false;
+    for (int v : seed) in_seed[v] = false;
+  }
+  return result;
+}
+
+SeparatorGenerator::SeparatorGenerator(
+    const Graph &G, const std::vector<std::vector<int>> &seeds,
+    size_t max_queue_memory)
+    : G(G), queue(max_queue_memory), in_nbh(G.N, false), checker(G) {
+  assert(!G.IsCompleteGraph());
+  for (auto &sep : SeparatorsFromSeeds(G, seeds)) {
+    if (!MarkDone(sep.vertices)) continue;
+    queue.push(sep.vertices);
+    buffer.emplace_back(std::move(sep));
+    num_seeded++;
+  }
+}
+
+void SeparatorGenerator::SeedVertices() {
+  // Datatypes that will be reused.
+  thread_local std::stack<int> component;
+  thread_local std::vector<int> separator;
+  thread_local std::vector<int> component_vertices;
+  thread_local std::vector<int> neighborhood;
+
+  enumerating = true;
 
   // Complete graphs don't have separators. We want this to return a
   // non-empty vector.
@@ -87,6 +406,7 @@ SeparatorGenerator::SeparatorGenerator(const Graph &G)
   // separates the original point).
   std::vector<bool> visited(G.N, false);
   for (int i = 0; i < G.N; i++) {
+    CheckCancelled(G.N + G.M);
     if (G.Adj(i).size() == G.N - 1) continue;
     neighborhood.clear();
     neighborhood.push_back(i);
@@ -102,6 +422,8 @@ SeparatorGenerator::SeparatorGenerator(const Graph &G)
       // Reset shared datastructures.
       assert(component.empty());
       separator.clear();
+      component_vertices.clear();
+      int component_M = 0;
 
       component.push(j);
       visited[j] = true;
@@ -109,8 +431,10 @@ SeparatorGenerator::SeparatorGenerator(const Graph &G)
       while (!component.empty()) {
         int cur = component.top();
         component.pop();
+        component_vertices.push_back(cur);
 
         for (int nb : G.Adj(cur)) {
+          if (!in_nbh[nb]) component_M++;
           if (!visited[nb]) {
             if (in_nbh[nb]) {
               separator.push_back(nb);
@@ -124,16 +448,7 @@ SeparatorGenerator::SeparatorGenerator(const Graph &G)
 
       for (auto k : neighborhood) visited[k] = false;
 
-      // std::sort(separator.begin(), separator.end());
-      for (int k : separator) sep_mask[k] = true;
-      if (done.find(sep_mask) == done.end()) {
-        queue.push(separator);
-        done.insert(sep_mask);
-
-        Separator sep(G, separator);
-        if (sep.fully_minimal) buffer.emplace_back(std::move(sep));
-      }
-      for (int k : separator) sep_mask[k] = false;
+      Enqueue(separator, component_vertices, component_M);
     }
 
     for (int j = 0; j < G.N; j++) visited[j] = false;
@@ -143,14 +458,23 @@ SeparatorGenerator::SeparatorGenerator(const Graph &G)
 
 std::vector<Separator> SeparatorGenerator::Next(int k) {
   // Datatypes that will be reused.
-  static std::stack<int> component;
-  static std::vector<int> separator;
+  thread_local std::stack<int> component;
+  thread_local std::vector<int> separator;
+  thread_local std::vector<int> component_vertices;
+
+  // The separators derived from the seeds are returned on their own, so
+  // that they can be tried before we start enumerating everything.
+  if (!enumerating) {
+    if (buffer.size()) return std::move(buffer);
+    SeedVertices();
+  }
 
   std::vector<bool> visited(G.N, false);
+  std::vector<int> cur_separator;
 
   while (!queue.empty() && buffer.size() < k) {
-    auto cur_separator = queue.front();
-    queue.pop();
+    queue.pop(cur_separator);
+    CheckCancelled(cur_separator.size() * (G.N + G.M));
 
     for (int x : cur_separator) {
       for (int j : G.Adj(x)) in_nbh[j] = true;
@@ -161,6 +485,8 @@ std::vector<Separator> SeparatorGenerator::Next(int k) {
         // Reset shared datastructures.
         assert(component.empty());
         separator.clear();
+        component_vertices.clear();
+        int component_M = 0;
 
         component.push(j);
         visited[j] = true;
@@ -168,8 +494,10 @@ std::vector<Separator> SeparatorGenerator::Next(int k) {
         while (!component.empty()) {
           int cur = component.top();
           component.pop();
+          component_vertices.push_back(cur);
 
           for (int nb : G.Adj(cur)) {
+            if (!in_nbh[nb]) component_M++;
             if (!visited[nb]) {
               if (in_nbh[nb]) {
                 separator.push_back(nb);
@@ -184,16 +512,7 @@ std::vector<Separator> SeparatorGenerator::Next(int k) {
         for (auto k : cur_separator) visited[k] = false;
         for (auto k : G.Adj(x)) visited[k] = false;
 
-        // std::sort(separator.begin(), separator.end());
-        for (int k : separator) sep_mask[k] = true;
-        if (done.find(sep_mask) == done.end()) {
-          queue.push(separator);
-          done.insert(sep_mask);
-
-          Separator sep(G, separator);
-          if (sep.fully_minimal) buffer.emplace_back(std::move(sep));
-        }
-        for (int k : separator) sep_mask[k] = false;
+        Enqueue(separator, component_vertices, component_M);
       }
 
       for (int j : cur_separator) in_nbh[j] = false;
@@ -204,3 +523,208 @@ std::vector<Separator> SeparatorGenerator::Next(int k) {
 
   return std::move(buffer);
 }
+
+DirectedSeparatorGenerator::DirectedSeparatorGenerator(
+    const Graph &G, const std::vector<std::vector<int>> &seeds,
+    size_t max_queue_memory)
+    : DirectedSeparatorGenerator(G, max_queue_memory) {
+  // These are handed out on their own by the first call to Next. They are
+  // not enqueued, as they need not have a full component containing a start.
+  enumerating = false;
+  std::vector<Separator> seeded;
+  for (auto &sep : SeparatorsFromSeeds(G, seeds))
+    if (emitted.Insert(sep.vertices)) {
+      seeded.emplace_back(std::move(sep));
+      num_seeded++;
+    }
+  seeded.insert(seeded.end(), make_move_iterator(buffer.begin()),
+                make_move_iterator(buffer.end()));
+  buffer = std::move(seeded);
+}
+
+DirectedSeparatorGenerator::DirectedSeparatorGenerator(const Graph &G,
+                                                       size_t max_queue_memory)
+    : G(G),
+      queue(max_queue_memory),
+      in_sep(G.N, false),
+      in_a(G.N, false),
+      visited(G.N, false),
+      found(G.N, false),
+      checker(G) {
+  assert(!G.IsCompleteGraph());
+
+  // Find a non-leaf vertex v of minimal degree, and start from N[v].
+  int v_min = -1;
+  for (int v = 0; v < G.N; v++)
+    if (G.Adj(v).size() > 1 &&
+        (v_min == -1 || G.Adj(v).size() < G.Adj(v_min).size()))
+      v_min = v;
+  assert(v_min > -1);
+  starts.push_back(v_min);
+  for (int nb : G.Adj(v_min))
+    if (G.Adj(nb).size() > 1) starts.push_back(nb);
+
+  // The exception is a star, whose only separator is its center.
+  if (starts.size() == 1) {
+    starts.clear();
+    buffer.emplace_back(G, std::vector<int>{v_min});
+  }
+}
+
+DirectedSeparatorGenerator::DirectedSeparatorGenerator(const Graph &G,
+                                                       int start,
+                                                       size_t max_queue_memory)
+    : G(G),
+      starts{start},
+      queue(max_queue_memory),
+      in_sep(G.N, false),
+      in_a(G.N, false),
+      visited(G.N, false),
+      found(G.N, false),
+      checker(G) {
+  assert(!G.IsCompleteGraph());
+}
+
+void DirectedSeparatorGenerator::Enqueue(const std::vector<int> &separator,
+                                         const std::vector<int> &component,
+                                         int component_M) {
+  if (!done.Insert(separator)) return;
+  queue.push(separator);
+  if (!emitted.Insert(separator)) return;
+  std::pair<int, int> largest_component;
+  if (checker.Check(separator, component, component_M, largest_component))
+    buffer.emplace_back(separator, largest_component);
+}
+
+void DirectedSeparatorGenerator::NextStart() {
+  // Datatypes that will be reused.
+  thread_local std::stack<int> component;
+  thread_local std::vector<int> separator;
+  thread_local std::vector<int> component_vertices;
+
+  assert(queue.empty());
+  done.clear();
+  int a = starts[++start_index];
+  if (G.Adj(a).size() == G.N - 1) return;
+
+  // The components of G \ N[a] all have a full neighborhood in N(a).
+  visited[a] = true;
+  for (int nb : G.Adj(a)) in_sep[nb] = visited[nb] = true;
+  for (int j = 0; j < G.N; j++) {
+    if (visited[j]) continue;
+    assert(component.empty());
+    separator.clear();
+    component_vertices.clear();
+    int component_M = 0;
+    component.push(j);
+    visited[j] = true;
+    while (!component.empty()) {
+      int cur = component.top();
+      component.pop();
+      component_vertices.push_back(cur);
+      for (int nb : G.Adj(cur))
+        if (in_sep[nb]) {
+          if (!found[nb]) separator.push_back(nb);
+          found[nb] = true;
+        } else {
+          component_M++;
+          if (!visited[nb]) {
+            component.push(nb);
+            visited[nb] = true;
+          }
+        }
+    }
+    for (int s : separator) found[s] = false;
+    Enqueue(separator, component_vertices, component_M);
+  }
+  for (int nb : G.Adj(a)) in_sep[nb] = false;
+  std::fill(visited.begin(), visited.end(), false);
+}
+
+std::vector<Separator> DirectedSeparatorGenerator::Next(int k) {
+  // Datatypes that will be reused.
+  thread_local std::stack<int> component;
+  thread_local std::vector<int> separator;
+  thread_local std::vector<int> component_vertices;
+  thread_local std::vector<int> extended;
+
+  // The separators derived from the seeds are returned on their own, and
+  // only the next call counts as enumerating, as in SeparatorGenerator.
+  if (!enumerating) {
+    if (buffer.size()) return std::move(buffer);
+    enumerating = true;
+  }
+
+  std::vector<int> cur_separator;
+  while (buffer.size() < k) {
+    if (queue.empty()) {
+      if (start_index + 1 == starts.size()) break;
+      NextStart();
+      continue;
+    }
+    queue.pop(cur_separator);
+    CheckCancelled((cur_separator.size() + 1) * (G.N + G.M));
+    int a = starts[start_index];
+
+    // Find C(S)_a once for this separator.
+    for (int s : cur_separator) in_sep[s] = true;
+    assert(component.empty() && !in_sep[a]);
+    component.push(a);
+    in_a[a] = true;
+    while (!component.empty()) {
+      int cur = component.top();
+      component.pop();
+      for (int nb : G.Adj(cur))
+        if (!in_a[nb] && !in_sep[nb]) {
+          in_a[nb] = true;
+          component.push(nb);
+        }
+    }
+
+    for (int x : cur_separator) {
+      // Grow S away from a: S_x = S + (N(x) \ C(S)_a). Since C(S)_a is a
+      // component of G \ S_x as well, we only look at the other ones.
+      extended.clear();
+      for (int nb : G.Adj(x))
+        if (!in_sep[nb] && !in_a[nb]) {
+          in_sep[nb] = true;
+          extended.push_back(nb);
+        }
+
+      for (int j = 0; j < G.N; j++) {
+        if (visited[j] || in_sep[j] || in_a[j]) continue;
+        assert(component.empty());
+        separator.clear();
+        component_vertices.clear();
+        int component_M = 0;
+        component.push(j);
+        visited[j] = true;
+        while (!component.empty()) {
+          int cur = component.top();
+          component.pop();
+          component_vertices.push_back(cur);
+          for (int nb : G.Adj(cur))
+            if (in_sep[nb]) {
+              if (!found[nb]) separator.push_back(nb);
+              found[nb] = true;
+            } else {
+              component_M++;
+              if (!visited[nb]) {
+                component.push(nb);
+                visited[nb] = true;
+              }
+            }
+        }
+        for (int s : separator) found[s] = false;
+        Enqueue(separator, component_vertices, component_M);
+      }
+      for (int v : extended) in_sep[v] = false;
+      std::fill(visited.begin(), visited.end(), false);
+    }
+
+    for (int s : cur_separator) in_sep[s] = false;
+    std::fill(in_a.begin(), in_a.end(), false);
+  }
+
+  return std::move(buffer);
+}
@@ -1,12 +1,10 @@
 #pragma once
-#define BOOST_DYNAMIC_BITSET_DONT_USE_FRIENDS
-#include <boost/dynamic_bitset.hpp>
-#include <boost/functional/hash.hpp>
-
 #include <parallel_hashmap/phmap.h>
-#include <bitset>
 
-#include <unordered_set>
+#include <cstdint>
+#include <cstdio>
+#include <set>
+#include <vector>
 
 #include "graph.hpp"
 
@@ -19,18 +17,181 @@ struct Separator {
   bool fully_minimal = false;
 
   Separator(const Graph &G, const std::vector<int> &vertices);
+
+  // A separator that is already known to be fully minimal.
+  Separator(const std::vector<int> &vertices,
+            std::pair<int, int> largest_component)
+      : vertices(vertices),
+        largest_component(largest_component),
+        fully_minimal(true) {}
+};
+
+// The check of the Separator constructor, for use during generation. There we
+// know the component H of G \ N(H) that a separator came from, and H is full
+// by construction. So we only search the other components, and stop as soon
+// as one of them is not full. The vertices are marked with timestamps, so
+// nothing has to be reset in between checks.
+class FullyMinimalChecker {
+ public:
+  FullyMinimalChecker(const Graph &G)
+      : G(G), sep_mark(G.N, 0), visit_mark(G.N, 0), touch_mark(G.N, 0) {}
+
+  // Returns whether `separator` = N(H) is fully minimal, for the component H
+  // given by its vertices and its number of edges (counted twice). If so,
+  // also stores its largest component (in the sense of Separator).
+  bool Check(const std::vector<int> &separator,
+             const std::vector<int> &component, int component_M,
+             std::pair<int, int> &largest_component);
+
+ protected:
+  const Graph &G;
+  uint32_t stamp = 0, touch_stamp = 0;
+  std::vector<uint32_t> sep_mark, visit_mark, touch_mark;
+  std::vector<int> stack;
+};
+
+// A 64-bit fingerprint of a set of (local) vertices: the sum of pseudo-random
+// hashes of the elements, so that it does not depend on the order in which the
+// vertices were found.
+struct SeparatorFingerprint {
+  uint64_t value = 0;
+
+  SeparatorFingerprint(const std::vector<int> &vertices) {
+    for (int v : vertices) value += Mix(v);
+  }
+
+  // The splitmix64 finalizer.
+  static inline uint64_t Mix(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+  }
+
+  // The fingerprint is well mixed already.
+  struct Hash {
+    inline size_t operator()(uint64_t value) const { return value; }
+  };
+};
+
+// A set of vertex sets, e.g. the separators that a generator has seen. It is
+// indexed by the fingerprints, and every set is also stored (sorted, as varint
+// encoded differences like in the SeparatorQueue), so that a hit is confirmed
+// by comparing the sets: a fingerprint collision must not make us drop a
+// separator.
+class SeparatorSet {
+ public:
+  // Inserts the set given by vertices (in any order), returns false if it was
+  // present already.
+  bool Insert(const std::vector<int> &vertices);
+
+  size_t size() const { return index_.size() + collisions_.size(); }
+  void clear();
+
+ protected:
+  // The offset in sets_ of the set with every fingerprint, and the (sorted)
+  // sets whose fingerprint collides with that of an earlier set.
+  phmap::flat_hash_map<uint64_t, size_t, SeparatorFingerprint::Hash> index_;
+  std::vector<uint8_t> sets_;
+  std::set<std::vector<int>> collisions_;
+};
+
+// Keeps track of the orbits of separators under a group of automorphisms of G,
+// given by generators: permutations of the local vertices. Separators in the
+// same orbit give the same bounds, so only one per orbit has to be expanded.
+// Orbits can be huge, so we only mark the first `max_orbit_size` images (found
+// by a BFS) of every expanded separator.
+class SeparatorOrbits {
+ public:
+  SeparatorOrbits(std::vector<std::vector<int>> generators,
+                  size_t max_orbit_size = 256)
+      : generators(std::move(generators)), max_orbit_size(max_orbit_size) {}
+
+  // Returns false if the separator is a (marked) image of one that was
+  // expanded before. Otherwise, marks its orbit and returns true.
+  bool Expand(const std::vector<int> &separator);
+
+ protected:
+  std::vector<std::vector<int>> generators;
+  size_t max_orbit_size;
+  SeparatorSet expanded;
+  std::vector<std::vector<int>> orbit;
+};
+
+// FIFO queue of vertex sets. Every set is sorted and stored as a varint
+// encoded list of differences, back to back in one flat buffer. As soon as
+// this buffer exceeds `max_memory` bytes, all further sets are written to a
+// temporary file. They are read back in chunks once the in-memory part is
+// exhausted, so the order of the queue is preserved.
+class SeparatorQueue {
+ public:
+  static constexpr size_t kDefaultMaxMemory = size_t(64) << 20;  // 64 MiB.
+
+  SeparatorQueue(size_t max_memory = kDefaultMaxMemory)
+      : max_memory_(max_memory) {}
+  ~SeparatorQueue();
+
+  SeparatorQueue(const SeparatorQueue &) = delete;
+  SeparatorQueue &operator=(const SeparatorQueue &) = delete;
+
+  bool empty() const { return size_ == 0; }
+  size_t size() const { return size_; }
+  size_t spilled() const { return spilled_; }
+
+  // Enqueues the set given by vertices (in any order).
+  void push(const std::vector<int> &vertices);
+
+  // Removes the front of the queue and stores it, sorted, in `vertices`.
+  void pop(std::vector<int> &vertices);
+
+  void clear();
+
+ protected:
+  // Reads the next chunk of the spill file into memory.
+  void Unspill();
+
+  size_t max_memory_;
+  size_t size_ = 0;
+  size_t spilled_ = 0;  // Total number of sets ever written to disk.
+
+  // The in-memory part: [size, v_1, v_2 - v_1, ...] for every set.
+  std::vector<uint8_t> memory_;
+  size_t memory_head_ = 0;
+
+  // The on-disk part, which always comes after the in-memory part. Every
+  // set is prefixed by the number of bytes of its encoding.
+  std::FILE *spill_ = nullptr;
+  size_t spill_size_ = 0;  // Number of sets that are on disk.
+  long spill_read_ = 0, spill_write_ = 0;
 };
 
+// Returns the fully minimal separators of G that can be derived from the given
+// seeds, sets of global vertices that e.g. separate a supergraph of G: for
+// every seed X and component H of G \ X, the neighborhood N(H). This list may
+// contain duplicates.
+std::vector<Separator> SeparatorsFromSeeds(
+    const Graph &G, const std::vector<std::vector<int>> &seeds);
+
 class SeparatorGenerator {
  public:
-  SeparatorGenerator(const Graph &G);
+  SeparatorGenerator(
+      const Graph &G,
+      size_t max_queue_memory = SeparatorQueue::kDefaultMaxMemory);
+
+  // Creates a generator that first returns the fully minimal separators of G
+  // that can be derived from the given seeds: sets of global vertices, e.g.
+  // separators of a supergraph of G. Only after those have been handed out,
+  // it starts enumerating all separators of G.
+  SeparatorGenerator(
+      const Graph &G, const std::vector<std::vector<int>> &seeds,
+      size_t max_queue_memory = SeparatorQueue::kDefaultMaxMemory);
 
-  bool HasNext() const { return !queue.empty(); }
+  bool HasNext() const { return !queue.empty() || !enumerating; }
   std::vector<Separator> Next(int k = 10000);
 
   void clear() {
     done.clear();
-    queue = {};
+    queue.clear();
   }
 
   // Reference to the graph for which we are generating separators.
@@ -39,22 +200,100 @@ class SeparatorGenerator {
   // In done we keep the seperators we have already enqueued, to make sure
   // they aren't processed again. In queue we keep all the ones we have
   // generated, but which we have not yet used to generate new ones.
-  std::queue<std::vector<int>> queue;
-  struct BitsetHash {
-    template <typename Block, typename Allocator>
-    inline size_t operator()(
-        const boost::dynamic_bitset<Block, Allocator> &a) const BOOST_NOEXCEPT {
-      std::size_t res = boost::hash_value(a.m_num_bits);
-      boost::hash_combine(res, a.m_bits);
-      return res;
-    }
-  };
-  phmap::flat_hash_set<boost::dynamic_bitset<>, BitsetHash> done;
+  SeparatorQueue queue;
+  SeparatorSet done;
 
   // In buffer we will keep all the (fully minimal) generated separators.
   std::vector<Separator> buffer;
 
   // Shared datatypes.
   std::vector<bool> in_nbh;
-  boost::dynamic_bitset<> sep_mask;
+  FullyMinimalChecker checker;
+
+  // Whether we have started the enumeration of all separators, and the
+  // number of separators that were derived from seeds.
+  bool enumerating = false;
+  size_t num_seeded = 0;
+
+ protected:
+  // Enqueues the separators around every vertex, see the constructor.
+  void SeedVertices();
+
+  // Marks the separator as done, returns false if it already was.
+  bool MarkDone(const std::vector<int> &separator) {
+    return done.Insert(separator);
+  }
+
+  // Marks the separator N(H) as done, and enqueues it if it is new. The
+  // component H is given by its vertices and (twice) its number of edges.
+  void Enqueue(const std::vector<int> &separator,
+               const std::vector<int> &component, int component_M);
+};
+
+// Alternative generator, following documents/fast-single-vertex-separators.tex.
+// Instead of growing separators in every direction from every vertex, it fixes
+// a start vertex a and only grows "away from a": from a separator S and x in
+// S, it takes S_x = S + (N(x) \ C(S)_a), and the neighborhoods of the
+// components of G \ S_x other than C(S_x)_a = C(S)_a. This finds minimal
+// separators S for which C(S)_a is a full component.
+//
+// Every fully minimal separator has a full component containing any non-leaf
+// vertex outside of it, and no separator contains all of N[v] for a non-leaf
+// vertex v. Hence we run this from every non-leaf vertex a in N[v], for some
+// v of minimal degree, to generate all fully minimal separators.
+class DirectedSeparatorGenerator {
+ public:
+  DirectedSeparatorGenerator(
+      const Graph &G,
+      size_t max_queue_memory = SeparatorQueue::kDefaultMaxMemory);
+
+  // As above, but the first batch consists of the separators derived from the
+  // given seeds, see SeparatorsFromSeeds.
+  DirectedSeparatorGenerator(
+      const Graph &G, const std::vector<std::vector<int>> &seeds,
+      size_t max_queue_memory = SeparatorQueue::kDefaultMaxMemory);
+
+  // Generate only the separators grown away from the given start vertex.
+  DirectedSeparatorGenerator(
+      const Graph &G, int start,
+      size_t max_queue_memory = SeparatorQueue::kDefaultMaxMemory);
+
+  bool HasNext() const {
+    return !buffer.empty() || !queue.empty() ||
+           start_index + 1 < starts.size();
+  }
+  std::vector<Separator> Next(int k = 10000);
+
+  // Reference to the graph for which we are generating separators.
+  const Graph &G;
+
+  // The start vertices, and the index of the one we are working on.
+  std::vector<int> starts;
+  int start_index = -1;
+
+  // In done we keep the separators that were enqueued from the current start
+  // vertex, in emitted the ones that were put into the buffer.
+  SeparatorQueue queue;
+  SeparatorSet done, emitted;
+
+  // In buffer we will keep all the (fully minimal) generated separators.
+  std::vector<Separator> buffer;
+
+  // Whether we have started the enumeration, and the number of separators
+  // that were derived from seeds.
+  bool enumerating = true;
+  size_t num_seeded = 0;
+
+ protected:
+  // Enqueues N(H) for the components H of G \ N[a], for the next start a.
+  void NextStart();
+
+  // Enqueues the separator N(H) if it is new for the current start vertex,
+  // see SeparatorGenerator::Enqueue.
+  void Enqueue(const std::vector<int> &separator,
+               const std::vector<int> &component, int component_M);
+
+  // Shared datatypes.
+  std::vector<bool> in_sep, in_a, visited, found;
+  FullyMinimalChecker checker;
 };
@@ -0,0 +1,138 @@
+#include "separator.hpp"
+
+// The checks must run in the release build as well.
+#undef NDEBUG
+#include <cassert>
+#include <sstream>
+
+// The separators as sorted sets, in sorted order.
+std::vector<std::vector<int>> SortedSeparators(
+    const std::vector<Separator> &seps) {
+  std::vector<std::vector<int>> result;
+  for (auto sep : seps) {
+    std::sort(sep.vertices.begin(), sep.vertices.end());
+    result.push_back(sep.vertices);
+  }
+  std::sort(result.begin(), result.end());
+  return result;
+}
+
+// Checks that the generated separators are distinct, and agree with the check
+// of the Separator constructor (which computes the components from scratch).
+void TestSeparators(const Graph &G, const std::vector<Separator> &seps) {
+  auto sorted = SortedSeparators(seps);
+  assert(std::adjacent_find(sorted.begin(), sorted.end()) == sorted.end());
+  for (const auto &sep : seps) {
+    Separator check(G, sep.vertices);
+    assert(check.fully_minimal);
+    assert(check.largest_component == sep.largest_component);
+  }
+}
+
+int main() {
+  std::vector<std::string> graphs{
+      // exact_015.gr.
+      "p tdp 26 30 18 22 18 13 22 23 22 9 22 2 22 4 22 20 22 24 22 12 10 11 10 "
+      "7 10 14 11 1 11 26 11 21 14 26 26 7 2 13 6 17 17 16 17 12 17 19 17 8 17 "
+      "15 1 5 1 13 13 21 13 25 13 24 12 3",
+      "p tdp 6 5 1 2 1 3 1 4 1 5 1 6", "p tdp 6 6 1 2 2 3 3 4 4 5 5 6 6 1",
+      "p tdp 6 6 1 2 2 3 3 4 4 1 3 5 4 6",
+      // exact_043.gr.
+      "p tdp 40 129 9 26 9 21 9 14 9 19 9 8 9 25 9 29 9 11 9 10 9 7 26 11 26 14 "
+      "26 10 26 8 26 27 24 30 24 14 24 38 30 18 30 20 30 5 30 1 30 2 30 37 30 "
+      "23 30 28 30 3 14 17 14 15 14 25 14 23 14 27 14 13 17 13 17 16 5 31 5 2 "
+      "5 4 5 1 5 3 5 13 5 29 5 22 31 1 31 37 31 18 31 39 31 2 7 12 7 25 7 19 7 "
+      "27 12 34 12 1 12 2 12 13 12 33 6 28 6 1 6 2 6 13 6 3 28 13 33 36 33 39 "
+      "33 38 33 37 33 13 33 35 36 29 25 23 25 22 25 8 25 10 25 11 25 29 25 19 "
+      "25 21 25 40 13 32 13 16 13 29 13 8 13 4 13 2 13 15 13 3 13 1 2 22 2 32 "
+      "2 29 2 3 2 4 22 3 22 18 22 40 22 38 22 1 22 21 34 35 34 37 34 38 34 39 "
+      "35 32 1 3 1 32 1 4 1 29 18 20 18 29 32 38 32 16 32 39 32 37 19 29 19 20 "
+      "29 20 29 3 21 38 20 38 20 40 38 23 38 27 11 27 11 8 27 8 27 10 23 40 8 "
+      "10"};
+
+  for (auto &graph : graphs) {
+    std::istringstream stream(graph);
+    LoadGraph(stream);
+    auto gen = SeparatorGenerator(full_graph);
+    auto seps = gen.Next(1'000'000);
+    assert(!gen.HasNext());
+    TestSeparators(full_graph, seps);
+
+    // The directed generator should give the same separators.
+    auto dir_gen = DirectedSeparatorGenerator(full_graph);
+    std::vector<Separator> dir_seps;
+    while (dir_gen.HasNext())
+      for (auto &sep : dir_gen.Next(1'000'000)) dir_seps.push_back(sep);
+    assert(SortedSeparators(dir_seps) == SortedSeparators(seps));
+    TestSeparators(full_graph, dir_seps);
+
+    // The same, but with a tiny queue that has to spill to disk.
+    auto gen_spill = SeparatorGenerator(full_graph, 16);
+    auto spill_seps = gen_spill.Next(1'000'000);
+    assert(full_graph.N < 10 || gen_spill.queue.spilled() > 0);
+    assert(spill_seps.size() == seps.size());
+    for (int s = 0; s < seps.size(); s++)
+      assert(spill_seps[s].vertices == seps[s].vertices);
+  }
+  assert(SortedSeparators(SeparatorGenerator(full_graph).Next(1'000'000))
+             .size() == 664);
+
+  // Both generators only count as enumerating after the seeded batch.
+  std::vector<std::vector<int>> seeds{
+      SeparatorGenerator(full_graph).Next(1)[0].vertices};
+  auto seeded_gen = SeparatorGenerator(full_graph, seeds);
+  auto seeded_dir_gen = DirectedSeparatorGenerator(full_graph, seeds);
+  assert(seeded_gen.num_seeded > 0 && seeded_dir_gen.num_seeded > 0);
+  seeded_gen.Next(1'000'000);
+  seeded_dir_gen.Next(1'000'000);
+  assert(!seeded_gen.enumerating && !seeded_dir_gen.enumerating);
+  seeded_gen.Next(1'000'000);
+  seeded_dir_gen.Next(1'000'000);
+  assert(seeded_gen.enumerating && seeded_dir_gen.enumerating);
+
+  // Check that the spilling queue is still first in, first out, and that it
+  // returns the sets sorted.
+  auto queue_set = [](int i) {
+    std::vector<int> set;
+    for (int j = i % 7; j >= 0; j--) set.push_back(i + 200 * j);
+    return set;
+  };
+  SeparatorQueue queue(16);
+  std::vector<int> popped;
+  for (int i = 0; i < 100; i++) {
+    queue.push(queue_set(i));
+    if (i % 3 == 0) {
+      queue.pop(popped);
+      std::vector<int> expected = queue_set(i / 3);
+      std::sort(expected.begin(), expected.end());
+      assert(popped == expected);
+    }
+  }
+  for (int i = 34; i < 100; i++) {
+    queue.pop(popped);
+    std::vector<int> expected = queue_set(i);
+    std::sort(expected.begin(), expected.end());
+    assert(popped == expected);
+  }
+  assert(queue.empty() && queue.spilled() > 0);
+
+  // A SeparatorSet does not depend on the order of the vertices, and tells
+  // apart sets that differ in a single vertex.
+  SeparatorSet set;
+  assert(set.Insert({3, 1, 2}) && !set.Insert({1, 2, 3}));
+  assert(set.Insert({1, 2}) && set.Insert({1, 2, 3, 4}) && set.Insert({}));
+  assert(!set.Insert({2, 1}) && !set.Insert({}) && set.size() == 4);
+  set.clear();
+  assert(set.size() == 0 && set.Insert({1, 2, 3}));
+
+  // Separators in the same orbit under the rotations of a 6-cycle.
+  std::vector<std::vector<int>> rotation{{1, 2, 3, 4, 5, 0}};
+  SeparatorOrbits orbits(rotation);
+  assert(orbits.Expand({0, 3}));
+  assert(!orbits.Expand({4, 1}) && !orbits.Expand({2, 5}));
+  assert(orbits.Expand({0, 2}) && !orbits.Expand({3, 5}));
+  SeparatorOrbits orbits_capped(rotation, 2);
+  assert(orbits_capped.Expand({0, 3}) && !orbits_capped.Expand({1, 4}));
+  assert(orbits_capped.Expand({2, 5}));
+  return 0;
+}
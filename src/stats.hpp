@@ -0,0 +1,119 @@
+#pragma once
+// Instrumentation of the hot paths of the solver: counters, cumulative timers
+// and a histogram of the recursion depth of Treedepth::Calculate. It is only
+// compiled in with -DTDULL_STATS (make STATS=1), otherwise all STATS_ macros
+// expand to nothing. Like all state of a computation, it is thread_local.
+#ifdef TDULL_STATS
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#define TDULL_STATS_COUNTERS(X)                                            \
+  X(cache_hits)                                                            \
+  X(cache_misses)                                                          \
+  X(exact_complete)                                                        \
+  X(exact_star)                                                            \
+  X(exact_cycle)                                                           \
+  X(exact_path)                                                            \
+  X(exact_small)                                                           \
+  X(exact_tree)                                                            \
+  X(core_number_calls)                                                     \
+  X(separators_generated)                                                  \
+  X(separators_scored)                                                     \
+  X(separator_trivial_returns)                                             \
+  X(separator_component_returns)                                           \
+  X(graph_constructions)                                                   \
+  X(graph_bytes)
+
+#define TDULL_STATS_TIMERS(X) \
+  X(time_core_numbers)        \
+  X(time_upper_bounds)        \
+  X(time_lower_bounds)        \
+  X(time_separator_generation)
+
+struct SolverStats {
+#define TDULL_STATS_FIELD(name) size_t name = 0;
+  TDULL_STATS_COUNTERS(TDULL_STATS_FIELD)
+#undef TDULL_STATS_FIELD
+#define TDULL_STATS_FIELD(name) double name = 0;
+  TDULL_STATS_TIMERS(TDULL_STATS_FIELD)
+#undef TDULL_STATS_FIELD
+
+  // The number of calls to Calculate at every recursion depth.
+  std::vector<size_t> depth_histogram;
+  int depth = 0;
+
+  void Print(std::ostream &stream, bool json) const {
+    const char *separator = json ? "{\n" : "Statistics:\n";
+#define TDULL_STATS_PRINT(name)                                        \
+  if (json)                                                            \
+    stream << separator << "  \"" #name "\": " << name;                \
+  else                                                                 \
+    stream << "  " << std::left << std::setw(30) << #name << name << "\n"; \
+  separator = ",\n";
+    TDULL_STATS_COUNTERS(TDULL_STATS_PRINT)
+    TDULL_STATS_TIMERS(TDULL_STATS_PRINT)
+#undef TDULL_STATS_PRINT
+    if (json) {
+      stream << ",\n  \"depth_histogram\": [";
+      for (int d = 0; d < depth_histogram.size(); d++)
+        stream << (d ? ", " : "") << depth_histogram[d];
+      stream << "]\n}" << std::endl;
+    } else {
+      stream << "  depth_histogram" << std::endl;
+      for (int d = 0; d < depth_histogram.size(); d++)
+        stream << "    " << std::setw(4) << d << "  " << depth_histogram[d]
+               << std::endl;
+    }
+  }
+};
+
+inline thread_local SolverStats solver_stats;
+
+// Adds the time until the end of its scope to a timer.
+class StatsTimer {
+ public:
+  StatsTimer(double &timer)
+      : timer(timer), start(std::chrono::steady_clock::now()) {}
+  ~StatsTimer() {
+    timer += std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                           start)
+                 .count();
+  }
+
+ private:
+  double &timer;
+  std::chrono::steady_clock::time_point start;
+};
+
+// Counts a call at the current recursion depth, and goes one level deeper
+// until the end of its scope.
+class StatsDepth {
+ public:
+  StatsDepth() {
+    auto &histogram = solver_stats.depth_histogram;
+    if (histogram.size() <= solver_stats.depth)
+      histogram.resize(solver_stats.depth + 1);
+    histogram[solver_stats.depth++]++;
+  }
+  ~StatsDepth() { solver_stats.depth--; }
+};
+
+#define STATS_CONCAT_(a, b) a##b
+#define STATS_CONCAT(a, b) STATS_CONCAT_(a, b)
+#define STATS_INC(counter) solver_stats.counter++
+#define STATS_ADD(counter, amount) solver_stats.counter += (amount)
+#define STATS_TIME(timer) \
+  StatsTimer STATS_CONCAT(stats_timer_, __LINE__)(solver_stats.timer)
+#define STATS_DEPTH() StatsDepth STATS_CONCAT(stats_depth_, __LINE__)
+#define STATS_RESET() solver_stats = SolverStats()
+#define STATS_PRINT(stream, json) solver_stats.Print(stream, json)
+#else
+#define STATS_INC(counter)
+#define STATS_ADD(counter, amount)
+#define STATS_TIME(timer)
+#define STATS_DEPTH()
+#define STATS_RESET()
+#define STATS_PRINT(stream, json)
+#endif
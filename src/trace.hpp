@@ -0,0 +1,145 @@
+#pragma once
+// Records the shape of the recursive search over time in the trace event
+// format of Chrome, which can be opened in chrome://tracing or
+// https://ui.perfetto.dev.
+//
+// Tracing is enabled by pointing trace_recorder to a recorder. Only the calls
+// of Treedepth::Calculate (and the phases within them) up to max_depth deep
+// are recorded, and those that took less than min_duration microseconds are
+// dropped, so that the overhead stays small: deeper calls only count their
+// depth. Improvements of the top-level bounds are recorded as instant events,
+// and as counters that show the bounds over time.
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <ostream>
+#include <vector>
+
+struct TraceEvent {
+  const char *name;
+  char phase;  // 'X' for a span, 'i' for an instant event.
+  double ts, dur;
+  int depth, N, M, lower, upper;
+};
+
+class TraceRecorder {
+ public:
+  int max_depth;
+  double min_duration;
+
+  // The number of open Calculate spans, and thus the depth of the recursion.
+  int depth = 0;
+
+  // The events, which are no longer recorded once there are max_events.
+  std::vector<TraceEvent> events;
+  size_t max_events = 1'000'000;
+  size_t dropped_events = 0;
+
+  TraceRecorder(int max_depth = 3, double min_duration = 10)
+      : max_depth(max_depth),
+        min_duration(min_duration),
+        start(std::chrono::steady_clock::now()) {}
+
+  // Microseconds since the recorder was created.
+  double Now() const {
+    return std::chrono::duration<double, std::micro>(
+               std::chrono::steady_clock::now() - start)
+        .count();
+  }
+
+  void Span(const char *name, double ts, int depth, int N, int M, int lower,
+            int upper) {
+    double dur = Now() - ts;
+    if (dur < min_duration) return;
+    Add({name, 'X', ts, dur, depth, N, M, lower, upper});
+  }
+
+  // Records the top-level bounds after phase, if they changed.
+  void Bounds(const char *phase, int lower, int upper) {
+    if (lower == last_lower && upper == last_upper) return;
+    last_lower = lower;
+    last_upper = upper;
+    Add({phase, 'i', Now(), 0, 0, 0, 0, lower, upper});
+  }
+
+  void Write(std::ostream &stream) const {
+    auto flags = stream.flags();
+    auto precision = stream.precision();
+    stream << std::fixed << std::setprecision(1)
+           << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    // The viewers expect the events ordered by time, and spans are recorded
+    // when they end.
+    std::vector<const TraceEvent *> sorted;
+    for (auto &event : events) sorted.push_back(&event);
+    std::stable_sort(sorted.begin(), sorted.end(),
+                     [](auto *e1, auto *e2) { return e1->ts < e2->ts; });
+    const char *separator = "";
+    for (auto *event : sorted) {
+      stream << separator << "{\"name\": \"" << event->name << "\", \"ph\": \""
+             << event->phase << "\", \"ts\": " << event->ts
+             << ", \"pid\": 1, \"tid\": 1, ";
+      if (event->phase == 'X') {
+        stream << "\"dur\": " << event->dur << ", \"args\": {\"depth\": "
+               << event->depth << ", \"N\": " << event->N
+               << ", \"M\": " << event->M;
+        if (event->lower > -1)
+          stream << ", \"lower\": " << event->lower
+                 << ", \"upper\": " << event->upper;
+        stream << "}}";
+      } else {
+        stream << "\"s\": \"g\", \"args\": {\"lower\": " << event->lower
+               << ", \"upper\": " << event->upper << "}},\n"
+               << "{\"name\": \"bounds\", \"ph\": \"C\", \"ts\": " << event->ts
+               << ", \"pid\": 1, \"tid\": 1, \"args\": {\"lower\": "
+               << event->lower << ", \"upper\": " << event->upper << "}}";
+      }
+      separator = ",\n";
+    }
+    stream << "\n]}" << std::endl;
+    stream.flags(flags);
+    stream.precision(precision);
+  }
+
+ private:
+  std::chrono::steady_clock::time_point start;
+  int last_lower = -1, last_upper = -1;
+
+  void Add(const TraceEvent &event) {
+    if (events.size() < max_events)
+      events.push_back(event);
+    else
+      dropped_events++;
+  }
+};
+
+// The recorder of the computation on this thread, if it is traced.
+inline thread_local TraceRecorder *trace_recorder = nullptr;
+
+// Records a span until the end of its scope, for a graph of N vertices and M
+// edges. A nested span (a call of Calculate) goes one level deeper, other
+// spans are phases of the current call. The bounds can be set before the end.
+class TraceSpan {
+ public:
+  int lower = -1, upper = -1;
+
+  TraceSpan(const char *name, int N, int M, bool nested)
+      : recorder(trace_recorder), name(name), N(N), M(M), nested(nested) {
+    if (!recorder) return;
+    depth = nested ? recorder->depth++ : recorder->depth - 1;
+    if (depth <= recorder->max_depth) ts = recorder->Now();
+  }
+  ~TraceSpan() {
+    if (!recorder) return;
+    if (nested) recorder->depth--;
+    if (depth <= recorder->max_depth)
+      recorder->Span(name, ts, depth, N, M, lower, upper);
+  }
+
+ private:
+  TraceRecorder *recorder;
+  const char *name;
+  int N, M;
+  bool nested;
+  int depth = 0;
+  double ts = 0;
+};
@@ -1,17 +1,28 @@
 #pragma once
+#include <atomic>
 #include <cassert>
-#include <ctime>
+#include <chrono>
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <numeric>
+#include <random>
 #include <set>
+#include <thread>
 
+#include "cancellation.hpp"
 #include "centrality.hpp"
 #include "exact_cache.hpp"
 #include "graph.hpp"
+#include "progress.hpp"
 #include "separator.hpp"
 #include "set_trie.hpp"
+#include "stats.hpp"
+#include "trace.hpp"
 #include "treedepth_tree.hpp"
+#ifdef USE_NAUTY
+#include "nauty.hpp"
+#endif
 
 // Trivial treedepth implementation, useful for simple sanity checks.
 int treedepth_trivial(const Graph &G) {
@@ -35,18 +46,22 @@ std::pair<int, int> treedepth_exact(const Graph &G) {
 
   // Do a quick check for special cases for which we know the answer.
   if (G.IsCompleteGraph()) {
+    STATS_INC(exact_complete);
     return {N, G.global[0]};
   } else if (G.IsStarGraph()) {
+    STATS_INC(exact_star);
     // Find node with max_degree.
     for (int v = 0; v < G.N; ++v)
       if (G.Adj(v).size() == G.max_degree) return {2, G.global[v]};
   } else if (G.IsCycleGraph()) {
+    STATS_INC(exact_cycle);
     // Find the bound, 1 + td of path of length N - 1.
     N--;
     int bnd = 2;
     while (N >>= 1) bnd++;
     return {bnd, G.global[0]};
   } else if (G.IsPathGraph()) {
+    STATS_INC(exact_path);
     // Find the bound, this is the ceil(log_2(N)).
     int bnd = 1;
     while (N >>= 1) bnd++;
@@ -66,10 +81,12 @@ std::pair<int, int> treedepth_exact(const Graph &G) {
         return {bnd, G.global[v]};
       }
   } else if (G.N < exactCacheSize) {
+    STATS_INC(exact_small);
     auto [td, root] = exactCache(G.adj);
     return {td, G.global[root]};
   } else if (G.IsTreeGraph()) {
     // TODO: this one is semi-expensive, but probably doesn't occur often.
+    STATS_INC(exact_tree);
     return treedepth_tree(G);
   }
   return {-1, -1};
@@ -87,7 +104,10 @@ std::pair<int, int> treedepth_exact(const Graph &G) {
 // - The root is an element of the subgraph which witnesses this upper_bound,
 //   and furthermore each connected component of the subgraph with the root
 //   removed is also in the cache.
-SetTrie cache;
+//
+// The cache, like all other state of a computation, is thread_local, so that
+// several threads can each solve their own graph (see the batch mode of main).
+thread_local SetTrie cache;
 
 // Cheap treedepth upper bound, useful for simple sanity checks.
 std::pair<int, int> treedepth_upper(const Graph &G) {
@@ -110,9 +130,168 @@ std::pair<int, int> treedepth_upper(const Graph &G) {
   assert(false);
 }
 
-// Global variable keeping track of the time we've spent so far, and the limit.
-time_t time_start_treedepth;
-int max_time_treedepth = INT_MAX;  // No time limit.
+// Statistics on seeding the separator generators of subgraphs with separators
+// of their parents: the number of separators derived from such seeds, and the
+// number of times the seeds sufficed, so that a full enumeration of the
+// separators of a subgraph was saved.
+thread_local size_t seeded_separators = 0;
+thread_local size_t separator_generations_saved = 0;
+
+// The maximum number of separators that a Treedepth keeps around to seed the
+// separator generators of its components.
+const int max_inherited_separators = 16;
+
+// Whether to use the DirectedSeparatorGenerator, which grows separators away
+// from a few start vertices, instead of the SeparatorGenerator. This and the
+// other settings below are thread_local, like the rest of the state, so that
+// every solver thread has its own (see TreedepthSolver::Options).
+thread_local bool use_directed_separator_generator = false;
+
+// Symmetry breaking: we only expand one separator per orbit under the
+// automorphisms of the top-level graph, and, if symmetry_pruning_deep is set,
+// of every subgraph with at least symmetry_min_vertices vertices. The
+// automorphisms are found by nauty, so this needs USE_NAUTY.
+thread_local bool symmetry_pruning_deep = false;
+const int symmetry_min_vertices = 32;
+thread_local size_t separators_pruned_by_symmetry = 0;
+thread_local double time_automorphisms = 0;
+
+// Generators of the automorphism group of G, as permutations of its local
+// vertices. Without nauty, we do not know any.
+std::vector<std::vector<int>> AutomorphismGenerators(const Graph &G) {
+#ifdef USE_NAUTY
+  clock_t start = clock();
+  auto generators = Nauty(G).generators;
+  time_automorphisms += double(clock() - start) / CLOCKS_PER_SEC;
+  return generators;
+#else
+  return {};
+#endif
+}
+
+// The SetTrie only matches identical vertex sets, but many subgraphs are
+// isomorphic copies of each other. So we can also store the bounds of graphs
+// with at most isomorphism_cache_max_vertices vertices under their canonical
+// form (found by nauty), with the root in canonical labels. Disabled (0) by
+// default.
+thread_local int isomorphism_cache_max_vertices = 0;
+thread_local size_t isomorphism_cache_lookups = 0;
+thread_local size_t isomorphism_cache_hits = 0;
+#ifdef USE_NAUTY
+struct IsomorphismCacheEntry {
+  int lower_bound, upper_bound, root;
+};
+thread_local phmap::flat_hash_map<std::vector<int>, IsomorphismCacheEntry,
+                                  CanonicalForm::Hash>
+    isomorphism_cache;
+#endif
+
+// Every spanning tree of G gives a lower bound on its treedepth, and which one
+// is best depends a lot on the root of the DfsTree. So we try the vertex of
+// maximum degree, at the top level also those of highest betweenness
+// centrality, and for graphs with at least dfs_tree_min_vertices vertices a few
+// random roots, until dfs_tree_time_budget (seconds) runs out. The centrality
+// counts against the same budget. Graphs with at least
+// dfs_tree_parallel_min_vertices vertices split the roots over dfs_tree_threads
+// threads.
+int dfs_tree_random_roots = 3;
+int dfs_tree_centrality_roots = 4;
+int dfs_tree_min_vertices = 64;
+double dfs_tree_time_budget = 0.05;
+thread_local int dfs_tree_threads = 1;
+const int dfs_tree_parallel_min_vertices = 2000;
+thread_local std::mt19937 dfs_tree_rng(42);
+
+// Statistics: the number of times that the other roots beat the vertex of
+// maximum degree, and the total increase of the lower bound.
+thread_local size_t dfs_tree_bound_improvements = 0;
+thread_local size_t dfs_tree_bound_gain = 0;
+
+int DfsTreeLowerBound(const Graph &G, bool top_level) {
+  std::vector<int> roots;
+  int v_max_degree = -1;
+  for (int v = 0; v < G.N; ++v)
+    if (G.Adj(v).size() == G.max_degree) {
+      v_max_degree = v;
+      break;
+    }
+  roots.push_back(v_max_degree);
+
+  // The centrality is quadratic, so on large graphs it samples the sources.
+  auto deadline =
+      std::chrono::steady_clock::now() +
+      std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+          std::chrono::duration<double>(dfs_tree_time_budget));
+  if (top_level && dfs_tree_centrality_roots) {
+    auto centrality = BetweennessCentrality(G, deadline);
+    std::vector<int> order(G.N);
+    std::iota(order.begin(), order.end(), 0);
+    int k = std::min(G.N, dfs_tree_centrality_roots);
+    std::partial_sort(
+        order.begin(), order.begin() + k, order.end(),
+        [&](int v, int w) { return centrality[v] > centrality[w]; });
+    roots.insert(roots.end(), order.begin(), order.begin() + k);
+  }
+  if (G.N >= dfs_tree_min_vertices)
+    for (int i = 0; i < dfs_tree_random_roots; i++)
+      roots.push_back(dfs_tree_rng() % G.N);
+
+  // The first root is always evaluated, the others while time permits.
+  int lower_first = treedepth_tree(G.DfsTree(roots[0])).first;
+  // The worker threads cannot throw, so they stop on a cancellation, which
+  // is then thrown by this thread.
+  const CancellationToken *token = cancellation_token;
+  auto evaluate = [&](int first, int step) {
+    int lower = 0;
+    for (int i = first; i < roots.size(); i += step) {
+      if (std::chrono::steady_clock::now() > deadline) break;
+      if (token && token->Expired()) break;
+      lower = std::max(lower, treedepth_tree(G.DfsTree(roots[i])).first);
+    }
+    return lower;
+  };
+  int lower = lower_first;
+  if (dfs_tree_threads > 1 && G.N >= dfs_tree_parallel_min_vertices) {
+    std::vector<int> lower_thread(dfs_tree_threads, 0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < dfs_tree_threads; t++)
+      threads.emplace_back([&, t] {
+        lower_thread[t] = evaluate(1 + t, dfs_tree_threads);
+      });
+    for (auto &thread : threads) thread.join();
+    for (int lower_t : lower_thread) lower = std::max(lower, lower_t);
+  } else {
+    lower = std::max(lower, evaluate(1, 1));
+  }
+  CheckCancelled(cancellation_check_work);
+
+  if (lower > lower_first) {
+    dfs_tree_bound_improvements++;
+    dfs_tree_bound_gain += lower - lower_first;
+  }
+  return lower;
+}
+
+// A path on P vertices has treedepth floor(log_2(P)) + 1, and long paths are
+// easy to find in sparse graphs. Every graph that misses the cache gets a
+// search of long_path_time_budget seconds (0 means a single attempt), the
+// top-level graph one of long_path_top_level_time_budget seconds.
+double long_path_time_budget = 0;
+double long_path_top_level_time_budget = 1;
+thread_local std::mt19937 long_path_rng(42);
+thread_local size_t long_path_bound_improvements = 0;
+
+// Tries to improve the given lower bound with a long path in G. This needs a
+// path on 2^lower vertices, so we don't even try if G is too small.
+int LongPathLowerBound(const Graph &G, int lower, double time_budget) {
+  if (lower >= 31 || (1 << lower) > G.N) return lower;
+  int P = G.LongPath(long_path_rng, time_budget, 1 << lower).size();
+  if (P < (1 << lower)) return lower;
+  long_path_bound_improvements++;
+  int lower_path = 1;
+  while (P >>= 1) lower_path++;
+  return lower_path;
+}
 
 // If we look for subsets, how much may those subsets differ from the set we
 // are considering?
@@ -151,6 +330,17 @@ class Treedepth {
   int lower = -1, upper = -1, root = -1;
   Node *node = nullptr;
 
+  // Separators (in global coordinates) of the graph that G is a component
+  // of. These are used as seeds for our own separator generator.
+  const std::vector<std::vector<int>> *inherited_separators = nullptr;
+
+  // Whether this is the top-level search, which reports its progress.
+  bool top_level = false;
+
+  // The core numbers of G, if they are known (e.g. because G is a component
+  // of the k-core of its parent, whose core numbers carry over).
+  std::vector<int> core_numbers;
+
   Treedepth(const Graph &G) : G(G) {
     // Set the trivial bounds.
     lower = std::max(G.M / G.N + 1, int(G.min_degree) + 1);
@@ -161,6 +351,21 @@ class Treedepth {
   std::vector<std::vector<int>> best_upper_separators;
   std::tuple<int, int, int> Calculate(int search_lbnd, int search_ubnd,
                                       bool store_best_separators = false) {
+    CheckCancelled(G.N + G.M);
+    STATS_DEPTH();
+    TraceSpan span("Calculate", G.N, G.M, /*nested=*/true);
+    auto result =
+        CalculateBounds(search_lbnd, search_ubnd, store_best_separators);
+    span.lower = std::get<0>(result);
+    span.upper = std::get<1>(result);
+#ifdef USE_NAUTY
+    if (canonical_form) StoreIsomorphic();
+#endif
+    return result;
+  }
+
+  std::tuple<int, int, int> CalculateBounds(int search_lbnd, int search_ubnd,
+                                            bool store_best_separators) {
     // If the trivial bounds suffice, we are done.
     if (search_ubnd <= lower || search_lbnd >= upper || lower == upper ||
         search_lbnd > search_ubnd) {
@@ -176,6 +381,7 @@ class Treedepth {
     std::vector<int> G_word = G;
     node = cache.Search(G_word);
     if (node) {
+      STATS_INC(cache_hits);
       // This graph was in the cache, retrieve lower/upper bounds.
       lower = node->lower_bound;
       upper = node->upper_bound;
@@ -184,15 +390,44 @@ class Treedepth {
       // If cached bouns suffice, return! :-).
       if (search_ubnd <= lower || search_lbnd >= upper || lower == upper)
         return {lower, upper, root};
+    } else {
+      STATS_INC(cache_misses);
+    }
+
+#ifdef USE_NAUTY
+    if (G.N <= isomorphism_cache_max_vertices) {
+      LookupIsomorphic();
+      if (search_ubnd <= lower || search_lbnd >= upper || lower == upper)
+        return {lower, upper, root};
     }
+#endif
 
-    if (G.N == full_graph.N) std::cerr << "full_graph: kCore" << std::flush;
+    if (top_level && verbose) std::cerr << "full_graph: kCore" << std::flush;
+
+    // The treedepth is at least the treewidth + 1, and so at least the
+    // degeneracy (the maximal core number) + 1.
+    if (core_numbers.empty()) {
+      STATS_TIME(time_core_numbers);
+      core_numbers = G.CoreNumbers();
+    }
+    int degeneracy =
+        *std::max_element(core_numbers.begin(), core_numbers.end());
+    if (degeneracy + 1 > lower) {
+      lower = degeneracy + 1;
+      if (node) node->lower_bound = lower;
+      if (search_ubnd <= lower || search_lbnd >= upper || lower == upper)
+        return {lower, upper, root};
+    }
 
     // Below we calculate the smallest k-core that G can contain. If this is
     // non- empty, we recursively calculate the treedepth on this core first.
     // This should give a nice lower bound pretty rapidly.
     int v_min_degree = -1;
-    auto cc_core = G.kCore(G.min_degree + 1);
+    std::vector<int> core_vertices;
+    for (int v = 0; v < G.N; v++)
+      if (core_numbers[v] > G.min_degree) core_vertices.push_back(v);
+    auto cc_core = G.ConnectedGraphs(core_vertices);
+    const bool is_core = !cc_core.empty();
     std::vector<std::vector<int>> kcore_best_separators;
 
     // If we do not have a kcore, simply remove a singly min degree vertex.
@@ -221,6 +456,7 @@ class Treedepth {
                 [](auto &c1, auto &c2) { return c1.M / c1.N > c2.M / c2.N; });
       for (const auto &cc : cc_core) {
         Treedepth treedepth_cc(cc);
+        if (is_core) treedepth_cc.core_numbers = InheritCoreNumbers(cc);
         auto [lower_cc, upper_cc, root_cc] = treedepth_cc.Calculate(
             std::max(lower, search_lbnd), std::min(upper, search_ubnd), true);
 
@@ -244,15 +480,21 @@ class Treedepth {
             make_move_iterator(treedepth_cc.best_upper_separators.end()));
       }
     }
-    if (G.N == full_graph.N)
-      std::cerr << " gave a lower bound of " << lower << std::endl;
+    if (top_level) {
+      if (verbose) std::cerr << " gave a lower bound of " << lower << std::endl;
+      ReportBounds("kCore");
+    }
 
     // If G doesn't exist in the cache, lets add it now, since we will start
     // doing some real work.
     if (node == nullptr) {
       // Do a cheap upper bound search.
-      auto [upper_H, root_H] = treedepth_upper(G);
-      if (G.N == full_graph.N)
+      int upper_H, root_H;
+      {
+        STATS_TIME(time_upper_bounds);
+        std::tie(upper_H, root_H) = treedepth_upper(G);
+      }
+      if (top_level && verbose)
         std::cerr << "full_graph: treedepth_upper(G) = " << upper_H
                   << std::endl;
       if (upper_H < upper) {
@@ -260,6 +502,7 @@ class Treedepth {
         upper = upper_H;
         root = root_H;
       }
+      ReportBounds("treedepth_upper");
 
       // Try to find a better lower bound from some of its big subsets.
       for (auto [node_sub, node_gap] : cache.BigSubsets(G_word, subset_gap)) {
@@ -276,21 +519,22 @@ class Treedepth {
         }
       }
 
-      // Compute DfsTree-tree from the most promising node once, and then
-      // evaluate the treedepth_tree on this tree.
-      int v_max_degree = -1;
-      for (int v = 0; v < G.N; ++v)
-        if (G.Adj(v).size() == G.max_degree) {
-          v_max_degree = v;
-          break;
-        }
-      lower = std::max(lower, treedepth_tree(G.DfsTree(v_max_degree)).first);
+      // Compute DfsTree-trees from some promising roots, and then evaluate
+      // the treedepth_tree on these trees.
+      {
+        STATS_TIME(time_lower_bounds);
+        lower = std::max(lower, DfsTreeLowerBound(G, top_level));
+        lower = LongPathLowerBound(G, lower,
+                                   top_level ? long_path_top_level_time_budget
+                                             : long_path_time_budget);
+      }
 
       // Insert into the cache.
       node = cache.Insert(G).first;
       node->lower_bound = lower;
       node->upper_bound = upper;
       node->root = root;
+      ReportBounds("lower bounds");
 
       if (search_ubnd <= lower || search_lbnd >= upper || lower == upper)
         return {lower, upper, root};
@@ -299,35 +543,70 @@ class Treedepth {
     // Main loop: try every separator as a set of roots.
     // new_lower tries to find a new treedepth lower bound on this subgraph.
     int new_lower = G.N;
-    if (G.N == full_graph.N)
+    if (top_level && verbose)
       std::cerr << "full_graph: bounds before separator loop " << lower
                 << " <= td <= " << upper << "." << std::endl;
 
-    for (auto &sep_vertices : kcore_best_separators) {
-      for (int &v : sep_vertices) v = G.LocalIndex(v);
-      Separator separator(G, sep_vertices);
-      if (separator.fully_minimal) {
-        SeparatorIteration(separator, search_lbnd, search_ubnd, new_lower,
-                           store_best_separators);
+    // The separators that were good for the k-core or for our parent are
+    // likely to be good for G as well, so we try those first.
+    if (inherited_separators)
+      kcore_best_separators.insert(kcore_best_separators.end(),
+                                   inherited_separators->begin(),
+                                   inherited_separators->end());
 
-        if (upper <= search_lbnd || lower == upper) {
-          if (G.N == full_graph.N)
-            std::cerr
-                << "full_graph: separator from kcore gives `upper == lower == "
-                << lower << "`, early exit. " << std::endl;
-          // Choosing separator already gives us a treedepth decomposition
-          // which is good enough (either a sister branch is at least this
-          // long, or it matches a previously proved lower bound for this
-          // subgraph) so we can use v as our root.
-          return {lower, upper, root};
-        }
-      }
+    // Separators in the same orbit under the automorphisms of G give the
+    // same bounds, so we only expand one of them.
+    std::unique_ptr<SeparatorOrbits> orbits;
+    if (top_level ||
+        (symmetry_pruning_deep && G.N >= symmetry_min_vertices)) {
+      auto generators = AutomorphismGenerators(G);
+      if (generators.size())
+        orbits = std::make_unique<SeparatorOrbits>(std::move(generators));
     }
 
-    SeparatorGenerator sep_generator(G);
     size_t total_separators = 0;
+    bool early_exit;
+    if (use_directed_separator_generator) {
+      DirectedSeparatorGenerator sep_generator(G, kcore_best_separators);
+      early_exit = SeparatorLoop(sep_generator, orbits.get(), search_lbnd,
+                                 search_ubnd, new_lower, store_best_separators,
+                                 total_separators);
+    } else {
+      SeparatorGenerator sep_generator(G, kcore_best_separators);
+      early_exit = SeparatorLoop(sep_generator, orbits.get(), search_lbnd,
+                                 search_ubnd, new_lower, store_best_separators,
+                                 total_separators);
+    }
+    if (early_exit) return {lower, upper, root};
+
+    if (top_level && verbose) {
+      std::cerr << "full_graph: generated total of " << total_separators
+                << " separators so far." << std::endl;
+      std::cerr << "full_graph: completed entire separator loop." << std::endl;
+    }
+    node->lower_bound = lower = std::max(lower, new_lower);
+    return {lower, upper, root};
+  }
+
+  // Runs SeparatorIteration on all separators that the generator gives, in
+  // batches sorted on the size of their largest component, skipping those in
+  // the orbit of an earlier one (if orbits is given). Returns true if we
+  // could exit early, because the bounds suffice.
+  template <class Generator>
+  bool SeparatorLoop(Generator &sep_generator, SeparatorOrbits *orbits,
+                     const int search_lbnd, const int search_ubnd,
+                     int &new_lower, bool store_best_separators,
+                     size_t &total_separators) {
+    TraceSpan span("SeparatorLoop", G.N, G.M, /*nested=*/false);
+    seeded_separators += sep_generator.num_seeded;
     while (sep_generator.HasNext()) {
-      auto separators = sep_generator.Next(100000);
+      std::vector<Separator> separators;
+      {
+        STATS_TIME(time_separator_generation);
+        separators = sep_generator.Next(100000);
+      }
+      STATS_ADD(separators_generated, separators.size());
+      if (solve_progress) solve_progress->AddSeparators(separators.size());
 
       total_separators += separators.size();
       std::sort(separators.begin(), separators.end(),
@@ -336,13 +615,21 @@ class Treedepth {
                 });
 
       for (int s = 0; s < separators.size(); s++) {
-        CheckTime();
+        CheckCancelled();
         const Separator &separator = separators[s];
+        if (orbits && !orbits->Expand(separator.vertices)) {
+          separators_pruned_by_symmetry++;
+          continue;
+        }
         SeparatorIteration(separator, search_lbnd, search_ubnd, new_lower,
                            store_best_separators);
+        ReportBounds("separator");
+        if (solve_progress)
+          solve_progress->cache_size.store(cache.size(),
+                                           std::memory_order_relaxed);
 
         if (search_ubnd <= lower || search_lbnd >= upper || lower == upper) {
-          if (G.N == full_graph.N) {
+          if (top_level && verbose) {
             std::cerr << "full_graph: generated total of " << total_separators
                       << " separators so far." << std::endl;
             std::cerr << "full_graph: separator " << s << " / "
@@ -359,17 +646,35 @@ class Treedepth {
           // is good enough (either a sister branch is at least this long, or it
           // matches a previously proved lower bound for this subgraph) so we
           // can use v as our root.
-          return {lower, upper, root};
+          if (!sep_generator.enumerating) separator_generations_saved++;
+          return true;
         }
       }
     }
-    if (G.N == full_graph.N) {
-      std::cerr << "full_graph: generated total of " << total_separators
-                << " separators so far." << std::endl;
-      std::cerr << "full_graph: completed entire separator loop." << std::endl;
+    return false;
+  }
+
+  // The core numbers of a component H of a k-core of G. Every j-core of G
+  // with j >= k lies within the k-core, so these are the same as in G.
+  std::vector<int> InheritCoreNumbers(const Graph &H) {
+    thread_local std::vector<int> local_index;
+    for (int v = 0; v < G.N; v++) {
+      if (G.global[v] >= local_index.size())
+        local_index.resize(G.global[v] + 1);
+      local_index[G.global[v]] = v;
     }
-    node->lower_bound = lower = std::max(lower, new_lower);
-    return {lower, upper, root};
+    std::vector<int> result(H.N);
+    for (int v = 0; v < H.N; v++)
+      result[v] = core_numbers[local_index[H.global[v]]];
+    return result;
+  }
+
+  // Reports the bounds of the top-level search to the trace and the progress
+  // reporter, if there are any.
+  void ReportBounds(const char *phase) {
+    if (!top_level) return;
+    if (trace_recorder) trace_recorder->Bounds(phase, lower, upper);
+    if (solve_progress) solve_progress->SetBounds(lower, upper);
   }
 
   // Returns whether this separator gave a lowering of the treedepth.
@@ -377,6 +682,7 @@ class Treedepth {
                                  const int search_lbnd, const int search_ubnd,
                                  int &new_lower,
                                  bool store_best_separators = false) {
+    STATS_INC(separators_scored);
     const int sep_size = separator.vertices.size();
     const int search_ubnd_sep =
         std::max(1, std::min(search_ubnd, upper) - sep_size);
@@ -390,7 +696,10 @@ class Treedepth {
     const int lower_trivial =
         separator.largest_component.second / separator.largest_component.first +
         1;
-    if (lower_trivial + sep_size >= new_lower) return;
+    if (lower_trivial + sep_size >= new_lower) {
+      STATS_INC(separator_trivial_returns);
+      return;
+    }
 
     // Sort the components of G \ separator on density.
     auto cc = G.WithoutVertices(separator.vertices);
@@ -399,7 +708,9 @@ class Treedepth {
     });
 
     for (auto &&H : cc) {
-      auto tuple = Treedepth(H).Calculate(search_lbnd_sep, search_ubnd_sep);
+      Treedepth treedepth_H(H);
+      treedepth_H.inherited_separators = &best_upper_separators;
+      auto tuple = treedepth_H.Calculate(search_lbnd_sep, search_ubnd_sep);
 
       const int lower_H = std::get<0>(tuple);
       const int upper_H = std::get<1>(tuple);
@@ -409,8 +720,10 @@ class Treedepth {
       search_lbnd_sep = std::max(search_lbnd_sep, lower_H);
 
       // If this won't give any new lower/upper bounds, we might as well stop.
-      if (upper_sep + sep_size > upper && lower_sep + sep_size >= new_lower)
+      if (upper_sep + sep_size > upper && lower_sep + sep_size >= new_lower) {
+        STATS_INC(separator_component_returns);
         return;
+      }
     }
     new_lower = std::min(new_lower, lower_sep + sep_size);
 
@@ -455,7 +768,9 @@ class Treedepth {
         }
       }
     }
-    if (upper_sep + sep_size == upper && store_best_separators) {
+    if (upper_sep + sep_size == upper &&
+        (store_best_separators ||
+         best_upper_separators.size() < max_inherited_separators)) {
       std::vector<int> best_upper_separator;
       best_upper_separator.resize(sep_size);
       for (int i = 0; i < sep_size; i++)
@@ -505,15 +820,50 @@ class Treedepth {
     }
   }
 
-  void CheckTime() {
-    // Check whether we are still in the time limits.
-    time_t now;
-    time(&now);
-    if (difftime(now, time_start_treedepth) > max_time_treedepth)
-      throw std::runtime_error(
-          "Ran out of time, spent " +
-          std::to_string(difftime(now, time_start_treedepth)) + " seconds.");
+#ifdef USE_NAUTY
+  // The canonical form of G, if we looked it up in the isomorphism cache.
+  std::unique_ptr<CanonicalForm> canonical_form;
+
+  // Improves our bounds with those of an isomorphic graph, if it is cached.
+  void LookupIsomorphic() {
+    canonical_form = std::make_unique<CanonicalForm>(G);
+    isomorphism_cache_lookups++;
+    auto it = isomorphism_cache.find(canonical_form->key);
+    if (it == isomorphism_cache.end()) return;
+    isomorphism_cache_hits++;
+
+    const IsomorphismCacheEntry &entry = it->second;
+    lower = std::max(lower, entry.lower_bound);
+    if (entry.upper_bound < upper) {
+      upper = entry.upper_bound;
+      root = G.global[canonical_form->labelling[entry.root]];
+    }
+    if (node) {
+      node->lower_bound = std::max(node->lower_bound, lower);
+      if (upper < node->upper_bound) {
+        node->upper_bound = upper;
+        node->root = root;
+      }
+    }
   }
+
+  // Stores our bounds in the isomorphism cache.
+  void StoreIsomorphic() {
+    int root_label = canonical_form->label[G.LocalIndex(root)];
+    auto [it, inserted] = isomorphism_cache.try_emplace(
+        std::move(canonical_form->key),
+        IsomorphismCacheEntry{lower, upper, root_label});
+    if (!inserted) {
+      IsomorphismCacheEntry &entry = it->second;
+      entry.lower_bound = std::max(entry.lower_bound, lower);
+      if (upper < entry.upper_bound) {
+        entry.upper_bound = upper;
+        entry.root = root_label;
+      }
+    }
+    canonical_form.reset();
+  }
+#endif
 };
 
 // Recursive function to reconstruct the tree that atains the treedepth.
@@ -537,17 +887,207 @@ void reconstruct(const Graph &G, int root, std::vector<int> &tree, int td) {
     reconstruct(H, new_root, tree, td - 1);
 }
 
-// Little helper function that returns the treedepth for the given graph.
-std::pair<int, std::vector<int>> treedepth(const Graph &G) {
+// Preprocessing on the block-cut tree of G. Every block is a subgraph of G, so
+// its treedepth is a lower bound for G. We solve the blocks from large to
+// small, where every block only has to beat the bound found so far, and the
+// results end up in the cache. The best separators of the blocks and the
+// articulation points are natural roots, so they are returned as seeds for the
+// separator generator of G.
+//
+// NOTE: The blocks are solved one after the other, on purpose. They share the
+// cache of this thread, so the search of G (and of later blocks) reuses their
+// results, and every block starts from the lower bound of the larger ones,
+// which often settles it right away. Blocks on worker threads would each need
+// their own cache, whose results would be lost.
+//
+// As in Treedepth::Calculate, we stop as soon as the lower bound reaches
+// search_ubnd.
+int BlockCutTreeLowerBound(const Graph &G,
+                           std::vector<std::vector<int>> &root_candidates,
+                           int search_ubnd) {
+  auto articulation_points = G.ArticulationPoints();
+  if (articulation_points.empty() || G.IsTreeGraph()) return 1;
+
+  std::vector<Graph> blocks;
+  for (auto &block : G.Blocks())
+    if (block.size() > 2) blocks.emplace_back(G, block);
+  std::sort(blocks.begin(), blocks.end(),
+            [](const Graph &b1, const Graph &b2) { return b1.N > b2.N; });
+
+  // The best separators of the blocks are good candidates for G as well.
+  int lower = 2;
+  for (const auto &B : blocks) {
+    if (lower >= search_ubnd) break;
+    Treedepth treedepth_B(B);
+    auto [lower_B, upper_B, root_B] =
+        treedepth_B.Calculate(lower, std::min(B.N, search_ubnd), true);
+    lower = std::max(lower, lower_B);
+    root_candidates.insert(
+        root_candidates.end(),
+        make_move_iterator(treedepth_B.best_upper_separators.begin()),
+        make_move_iterator(treedepth_B.best_upper_separators.end()));
+  }
+
+  // An articulation point that only cuts off trees is not much of a root, so
+  // we only keep those that separate at least two components with a cycle.
+  for (int v : articulation_points) {
+    CheckCancelled(G.N + G.M);
+    int cyclic_components = 0;
+    for (const auto &H : G.WithoutVertex(v))
+      if (!H.IsTreeGraph()) cyclic_components++;
+    if (cyclic_components > 1) root_candidates.push_back({G.global[v]});
+  }
+  if (verbose)
+    std::cerr << "full_graph: block-cut tree has " << blocks.size()
+              << " non-trivial blocks and " << articulation_points.size()
+              << " articulation points, giving " << root_candidates.size()
+              << " root candidates and a lower bound of " << lower << "."
+              << std::endl;
+  return lower;
+}
+
+// Kernelisation: leaves with the same neighbor x are false twins, and all but
+// one of them can be removed. Given a decomposition of the kernel, either the
+// remaining leaf l hangs below x, or we swap l and x (as l is only adjacent
+// to x, this is still a decomposition). Then x is not at the bottom, so the
+// removed leaves can be children of x without increasing the depth.
+//
+// Returns the kernel, and stores the classes [l, removed leaves...].
+Graph PendantTwinKernel(const Graph &G,
+                        std::vector<std::vector<int>> &pendant_twins) {
+  if (G.N <= 2) return G;
+  auto [G_sym, vertices_original] = G.WithoutSymmetricNeighboorhoods();
+  std::vector<bool> removed(G.N, false);
+  for (auto &twins : vertices_original)
+    if (twins.size() > 1 && G.Adj(twins[0]).size() == 1) {
+      for (int i = 1; i < twins.size(); i++) removed[twins[i]] = true;
+      pendant_twins.emplace_back(std::move(twins));
+    }
+  if (pendant_twins.empty()) return G;
+
+  std::vector<int> kernel_vertices;
+  for (int v = 0; v < G.N; v++)
+    if (!removed[v]) kernel_vertices.push_back(v);
+  if (verbose)
+    std::cerr << "full_graph: removed " << G.N - kernel_vertices.size()
+              << " pendant twins." << std::endl;
+  return Graph(G, kernel_vertices);
+}
+
+// Adds the removed pendant twins to the (0 based) tree of the kernel.
+void ReconstructPendantTwins(
+    const Graph &G, const std::vector<std::vector<int>> &pendant_twins,
+    std::vector<int> &tree) {
+  // The permutation that swaps the leaves that are above their neighbor.
+  std::vector<int> swap(G.N);
+  std::iota(swap.begin(), swap.end(), 0);
+  for (const auto &twins : pendant_twins) {
+    int leaf = twins[0], x = G.Adj(leaf)[0];
+    bool leaf_above_x = false;
+    for (int v = tree[x]; v > -1 && !leaf_above_x; v = tree[v])
+      leaf_above_x = (v == leaf);
+    if (leaf_above_x) std::swap(swap[leaf], swap[x]);
+  }
+  std::vector<int> new_tree(G.N, -2);
+  for (int v = 0; v < G.N; v++)
+    if (tree[v] != -2) new_tree[swap[v]] = tree[v] == -1 ? -1 : swap[tree[v]];
+  tree = std::move(new_tree);
+
+  for (const auto &twins : pendant_twins)
+    for (int i = 1; i < twins.size(); i++) tree[twins[i]] = G.Adj(twins[0])[0];
+}
+
+// Bounds the treedepth of G, with the search bounds of Treedepth::Calculate.
+// If this gives an upper bound of at most search_lbnd, or settles the
+// treedepth and reconstruct_settled is set, it also reconstructs a
+// decomposition attaining the upper bound. Otherwise the tree is empty.
+std::tuple<int, int, std::vector<int>> treedepth_bounds(
+    const Graph &G, int search_lbnd, int search_ubnd,
+    bool reconstruct_settled = true) {
   cache = SetTrie();
-  time(&time_start_treedepth);
-  int td = std::get<1>(Treedepth(G).Calculate(1, G.N));
-  std::vector<int> tree(G.N, -2);
-  std::cerr << "full_graph: treedepth is " << td << "." << std::endl;
-  reconstruct(G, -1, tree, td);
+  STATS_RESET();
+  seeded_separators = separator_generations_saved = 0;
+  separators_pruned_by_symmetry = 0;
+  time_automorphisms = 0;
+  isomorphism_cache_lookups = isomorphism_cache_hits = 0;
+  dfs_tree_bound_improvements = dfs_tree_bound_gain = 0;
+  long_path_bound_improvements = 0;
+  dfs_tree_rng.seed(42);
+  long_path_rng.seed(42);
+#ifdef USE_NAUTY
+  isomorphism_cache.clear();
+#endif
+  if (solve_progress) solve_progress->SetBounds(1, G.N);
+
+  std::vector<std::vector<int>> pendant_twins;
+  Graph kernel = PendantTwinKernel(G, pendant_twins);
+
+  std::vector<std::vector<int>> root_candidates;
+  int lower_blocks =
+      BlockCutTreeLowerBound(kernel, root_candidates, search_ubnd);
+  Treedepth solver(kernel);
+  solver.top_level = true;
+  solver.lower = std::max(solver.lower, lower_blocks);
+  solver.inherited_separators = &root_candidates;
+  if (solve_progress) solve_progress->SetBounds(solver.lower, solver.upper);
+  auto [lower, upper, root] = solver.Calculate(search_lbnd, search_ubnd);
+  if (trace_recorder) trace_recorder->Bounds("done", lower, upper);
+  if (solve_progress) {
+    solve_progress->SetBounds(lower, upper);
+    solve_progress->cache_size.store(cache.size(), std::memory_order_relaxed);
+  }
+  if (verbose)
+    std::cerr << "full_graph: " << lower << " <= treedepth <= " << upper << "."
+              << std::endl;
+  std::vector<int> tree;
+  if ((reconstruct_settled && lower == upper) || upper <= search_lbnd) {
+    tree.resize(G.N, -2);
+    reconstruct(kernel, -1, tree, upper);
+    ReconstructPendantTwins(G, pendant_twins, tree);
+
+    // The reconstruction is 0 based, the output is 1 based indexing, fix.
+    for (auto &v : tree) v++;
+  }
+  if (!verbose) return {lower, upper, std::move(tree)};
   std::cerr << "There are " << cache.size() << " subsets in the full cache."
             << std::endl;
-  // The reconstruction is 0 based, the output is 1 based indexing, fix.
-  for (auto &v : tree) v++;
-  return {td, std::move(tree)};
+  std::cerr << "Seeding gave " << seeded_separators
+            << " separators, and saved " << separator_generations_saved
+            << " full separator generations." << std::endl;
+  std::cerr << "DfsTrees of other roots improved the lower bound "
+            << dfs_tree_bound_improvements << " times, by "
+            << dfs_tree_bound_gain << " in total." << std::endl;
+  std::cerr << "Long paths improved the lower bound "
+            << long_path_bound_improvements << " times." << std::endl;
+#ifdef USE_NAUTY
+  std::cerr << "Symmetry pruned " << separators_pruned_by_symmetry
+            << " separators, finding automorphisms took "
+            << time_automorphisms << " seconds." << std::endl;
+  if (isomorphism_cache_max_vertices)
+    std::cerr << "Isomorphism cache has " << isomorphism_cache.size()
+              << " graphs, and gave " << isomorphism_cache_hits << " hits in "
+              << isomorphism_cache_lookups << " lookups." << std::endl;
+#endif
+  return {lower, upper, std::move(tree)};
+}
+
+// Little helper function that returns the treedepth for the given graph.
+std::pair<int, std::vector<int>> treedepth(const Graph &G) {
+  auto [lower, upper, tree] = treedepth_bounds(G, 1, G.N);
+  assert(lower == upper);
+  return {upper, std::move(tree)};
+}
+
+// Decides whether the treedepth of G is at most k. The search stops as soon
+// as the lower bound exceeds k, or the upper bound is at most k. Returns the
+// answer, the bound that proves it, and in the first case a decomposition of
+// that depth.
+std::tuple<bool, int, std::vector<int>> treedepth_decide(const Graph &G,
+                                                         int k) {
+  // A NO answer needs no decomposition, even if the treedepth is settled.
+  auto [lower, upper, tree] =
+      treedepth_bounds(G, k, k + 1, /*reconstruct_settled=*/false);
+  if (upper <= k) return {true, upper, std::move(tree)};
+  assert(lower > k);
+  return {false, lower, {}};
 }
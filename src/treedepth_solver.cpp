@@ -0,0 +1,75 @@
+#include "treedepth_solver.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "treedepth.hpp"
+
+TreedepthSolver::Result TreedepthSolver::Solve(const EdgeList &graph,
+                                               const Options &options) {
+  token.Reset(options.time_limit);
+  bool verbose_before = verbose;
+  verbose = options.verbose;
+  use_directed_separator_generator = options.directed_separators;
+  dfs_tree_threads = options.dfs_tree_threads;
+  symmetry_pruning_deep = options.deep_symmetry;
+  isomorphism_cache_max_vertices = options.isomorphism_cache_max_vertices;
+  Result result;
+  try {
+    for (auto [a, b] : graph.edges)
+      if (a < 0 || b < 0 || a >= graph.N || b >= graph.N || a == b)
+        throw std::invalid_argument("Invalid edge " + std::to_string(a) +
+                                    " " + std::to_string(b) + ".");
+    cancellation_token = &token;
+
+    // The solver expects a connected graph, so we solve every component on
+    // its own, and put the decompositions next to each other.
+    std::vector<std::vector<int>> adj(graph.N);
+    for (auto [a, b] : graph.edges) {
+      adj[a].push_back(b);
+      adj[b].push_back(a);
+    }
+    // The graph may list an edge several times, or in both directions.
+    for (auto &neighbours : adj) {
+      std::sort(neighbours.begin(), neighbours.end());
+      neighbours.erase(std::unique(neighbours.begin(), neighbours.end()),
+                       neighbours.end());
+    }
+    std::vector<int> local(graph.N, -1);
+    result.treedepth = 0;
+    result.parent.resize(graph.N, -1);
+    for (int s = 0; s < graph.N; s++) {
+      if (local[s] != -1) continue;
+      std::vector<int> vertices{s};
+      local[s] = 0;
+      for (int i = 0; i < vertices.size(); i++)
+        for (int w : adj[vertices[i]])
+          if (local[w] == -1) {
+            local[w] = vertices.size();
+            vertices.push_back(w);
+          }
+      std::vector<std::pair<int, int>> edges;
+      for (int v : vertices)
+        for (int w : adj[v])
+          if (v < w) edges.emplace_back(local[v], local[w]);
+
+      LoadGraph(Graph(vertices.size(), edges));
+      auto [td, tree] = treedepth(full_graph);
+      result.treedepth = std::max(result.treedepth, td);
+      for (int i = 0; i < vertices.size(); i++)
+        if (tree[i]) result.parent[vertices[i]] = vertices[tree[i] - 1];
+    }
+  } catch (std::exception &e) {
+    result = {-1, {}, e.what()};
+  }
+
+  // Free the memory of this thread, the solver may be idle for a while.
+  cancellation_token = nullptr;
+  verbose = verbose_before;
+  cache = SetTrie();
+#ifdef USE_NAUTY
+  isomorphism_cache = decltype(isomorphism_cache)();
+#endif
+  UnloadGraph();
+  return result;
+}
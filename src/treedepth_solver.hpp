@@ -0,0 +1,50 @@
+#pragma once
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "cancellation.hpp"
+
+// The interface for embedding tdULL in other programs, as the library
+// libtdull.a. All state of a computation is thread_local, so one thread can
+// solve a graph while others solve theirs: use one TreedepthSolver per thread.
+class TreedepthSolver {
+ public:
+  // A graph on the vertices 0, ..., N - 1.
+  struct EdgeList {
+    int N = 0;
+    std::vector<std::pair<int, int>> edges;
+  };
+
+  struct Options {
+    double time_limit = 0;  // In seconds, 0 for no limit.
+    bool verbose = false;   // Report on the progress of the solve on stderr.
+
+    // Search settings, see treedepth.hpp. The last two need nauty.
+    bool directed_separators = false;
+    int dfs_tree_threads = 1;
+    bool deep_symmetry = false;
+    int isomorphism_cache_max_vertices = 0;
+  };
+
+  struct Result {
+    int treedepth = -1;  // -1 if the solve failed.
+
+    // The parent of every vertex in an optimal decomposition, -1 for roots.
+    std::vector<int> parent;
+
+    // Why the solve failed: "Cancelled.", a timeout, or an invalid graph.
+    std::string error;
+  };
+
+  // Computes the treedepth of the graph, with an optimal decomposition.
+  Result Solve(const EdgeList &graph, const Options &options);
+  Result Solve(const EdgeList &graph) { return Solve(graph, Options()); }
+
+  // Makes the running Solve (if any) return as soon as possible, with an
+  // error. May be called from any thread.
+  void Cancel() { token.Cancel(); }
+
+ private:
+  CancellationToken token;
+};
@@ -0,0 +1,157 @@
+#include "treedepth_solver.hpp"
+
+// The checks must run in the release build as well.
+#undef NDEBUG
+#include <cassert>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+TreedepthSolver::EdgeList ReadEdgeList(const std::string &fn) {
+  std::ifstream input(fn);
+  std::string p, tdp;
+  int M;
+  TreedepthSolver::EdgeList graph;
+  input >> p >> tdp >> graph.N >> M;
+  graph.edges.resize(M);
+  for (auto &[a, b] : graph.edges) {
+    input >> a >> b;
+    a--, b--;
+  }
+  return graph;
+}
+
+// Checks that parent is a forest of the given depth, in which the endpoints of
+// every edge are related.
+bool IsDecomposition(const TreedepthSolver::EdgeList &graph,
+                     const std::vector<int> &parent, int depth) {
+  if (parent.size() != graph.N) return false;
+  std::vector<int> level(graph.N, 0);
+  for (int v = 0; v < graph.N; v++) {
+    for (int w = v; w != -1; w = parent[w]) {
+      if (++level[v] > depth) return false;
+    }
+  }
+  for (auto [a, b] : graph.edges) {
+    if (level[a] < level[b]) std::swap(a, b);
+    while (level[a] > level[b]) a = parent[a];
+    if (a != b) return false;
+  }
+  return true;
+}
+
+int main() {
+  std::string root = "../input/exact/";
+
+  // Small cases.
+  TreedepthSolver solver;
+  assert(solver.Solve({0, {}}).treedepth == 0);
+  assert(solver.Solve({3, {}}).treedepth == 1);
+  auto result = solver.Solve({4, {{0, 1}, {1, 2}, {2, 3}}});
+  assert(result.treedepth == 3 && result.error.empty());
+  assert(IsDecomposition({4, {{0, 1}, {1, 2}, {2, 3}}}, result.parent, 3));
+  result = solver.Solve({5, {{0, 1}, {3, 4}}});
+  assert(result.treedepth == 2);
+  assert(IsDecomposition({5, {{0, 1}, {3, 4}}}, result.parent, 2));
+  assert(solver.Solve({2, {{0, 2}}}).treedepth == -1);
+  assert(solver.Solve({2, {{1, 1}}}).error != "");
+
+  // The solver is silent, unless asked otherwise.
+  std::stringstream log;
+  auto *cerr_buffer = std::cerr.rdbuf(log.rdbuf());
+  solver.Solve(ReadEdgeList(root + "exact_001.gr"));
+  assert(log.str().empty());
+  solver.Solve(ReadEdgeList(root + "exact_001.gr"), {0, /*verbose=*/true});
+  assert(!log.str().empty());
+  std::cerr.rdbuf(cerr_buffer);
+
+  // Duplicate edges, and edges in both directions.
+  result = solver.Solve({3, {{0, 1}, {1, 0}, {0, 1}, {1, 2}, {2, 1}}});
+  assert(result.treedepth == 2);
+  assert(IsDecomposition({3, {{0, 1}, {1, 2}}}, result.parent, 2));
+  for (auto [fn, true_depth] : std::vector<std::pair<std::string, int>>{
+           {"exact_001.gr", 6}, {"exact_003.gr", 11}, {"exact_005.gr", 5},
+           {"exact_013.gr", 7}}) {
+    auto graph = ReadEdgeList(root + fn);
+    for (int e = graph.edges.size() - 1; e >= 0; e--) {
+      auto [a, b] = graph.edges[e];
+      graph.edges.emplace_back(b, a);
+      if (e % 2) graph.edges.emplace_back(a, b);
+    }
+    result = solver.Solve(graph);
+    assert(result.treedepth == true_depth);
+    assert(IsDecomposition(graph, result.parent, true_depth));
+  }
+
+  // The search settings are per solve.
+  TreedepthSolver::Options options;
+  options.directed_separators = true;
+  options.dfs_tree_threads = 2;
+  assert(solver.Solve(ReadEdgeList(root + "exact_013.gr"), options)
+             .treedepth == 7);
+
+  // Solve several graphs at the same time, one solver per thread.
+  std::vector<std::pair<std::string, int>> truth_values{
+      {"exact_001.gr", 6},  {"exact_003.gr", 11}, {"exact_007.gr", 9},
+      {"exact_017.gr", 10}, {"exact_025.gr", 8},  {"exact_035.gr", 9}};
+  std::vector<std::thread> threads;
+  for (auto [fn, true_depth] : truth_values)
+    threads.emplace_back([fn = fn, true_depth = true_depth, &root] {
+      for (int repeat = 0; repeat < 2; repeat++) {
+        auto graph = ReadEdgeList(root + fn);
+        TreedepthSolver solver;
+        auto result = solver.Solve(graph);
+        assert(result.treedepth == true_depth);
+        assert(IsDecomposition(graph, result.parent, true_depth));
+      }
+    });
+  for (auto &thread : threads) thread.join();
+
+  // Cancel a long computation from another thread.
+  auto graph = ReadEdgeList(root + "exact_061.gr");
+  auto start = std::chrono::steady_clock::now();
+  std::thread cancel_thread([&] {
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    solver.Cancel();
+  });
+  result = solver.Solve(graph);
+  cancel_thread.join();
+  double time = std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - start)
+                    .count();
+  assert(result.treedepth == -1 && result.error == "Cancelled.");
+  std::cout << "Cancelling took " << time << " seconds." << std::endl;
+
+  // The solver can be reused after a cancellation.
+  assert(solver.Solve(ReadEdgeList(root + "exact_005.gr")).treedepth == 5);
+
+  // And a time limit, which may be below a second.
+  start = std::chrono::steady_clock::now();
+  result = solver.Solve(graph, {/*time_limit=*/0.2});
+  time = std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+             .count();
+  assert(result.treedepth == -1 && result.error.rfind("Ran out", 0) == 0);
+  std::cout << "A time limit of 0.2 seconds took " << time << " seconds."
+            << std::endl;
+
+  // The preprocessing of a large sparse graph also stops at the time limit: a
+  // sun, a cycle of 2500 vertices with a pendant vertex on each of them.
+  TreedepthSolver::EdgeList sun{5000, {}};
+  for (int v = 0; v < 2500; v++) {
+    sun.edges.emplace_back(v, (v + 1) % 2500);
+    sun.edges.emplace_back(v, 2500 + v);
+  }
+  start = std::chrono::steady_clock::now();
+  result = solver.Solve(sun, {/*time_limit=*/0.5});
+  time = std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+             .count();
+  assert(result.treedepth == -1 && result.error.rfind("Ran out", 0) == 0);
+  assert(time < 0.75);
+  std::cout << "A time limit of 0.5 seconds on a sun took " << time
+            << " seconds." << std::endl;
+  return 0;
+}
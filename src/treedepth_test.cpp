@@ -7,6 +7,15 @@
 #include "treedepth.hpp"
 
 int main(int argc, char **argv) {
+  // With --decide, we time the decision queries td <= true_depth - 1 (NO)
+  // and td <= true_depth (YES) instead of the full computation.
+  bool decide = false;
+  for (int i = 1; i < argc; i++) {
+    if (std::string(argv[i]) == "--directed-separators")
+      use_directed_separator_generator = true;
+    if (std::string(argv[i]) == "--decide") decide = true;
+  }
+
   std::string root = "../input/exact/";
   std::vector<std::pair<std::string, int>> truth_values{
       {"exact_001.gr", 6},  {"exact_003.gr", 11}, {"exact_005.gr", 5},
@@ -37,6 +46,28 @@ int main(int argc, char **argv) {
     std::ifstream input(root + fn, std::ios::in);
     LoadGraph(input);
     auto start = std::chrono::steady_clock::now();
+    if (decide) {
+      auto [no, lower, no_tree] = treedepth_decide(full_graph, true_depth - 1);
+      double time_no = std::chrono::duration<double>(
+                           std::chrono::steady_clock::now() - start)
+                           .count();
+      auto [yes, upper, yes_tree] = treedepth_decide(full_graph, true_depth);
+      double time_yes = std::chrono::duration<double>(
+                            std::chrono::steady_clock::now() - start)
+                            .count() -
+                        time_no;
+      if (no || lower != true_depth || !yes || upper != true_depth) {
+        std::cout << "TEST FAILED!" << std::endl
+                  << "\t example " << fn << " decides td <= "
+                  << true_depth - 1 << " with " << lower << ", and td <= "
+                  << true_depth << " with " << upper << std::endl;
+        return 1;
+      }
+      std::cout << "Deciding NO took " << time_no << " seconds, YES took "
+                << time_yes << " seconds." << std::endl
+                << std::endl;
+      continue;
+    }
     int depth = treedepth(full_graph).first;
     if (depth != true_depth) {
       std::cout << "TEST FAILED!" << std::endl
@@ -1,119 +1,74 @@
 #pragma once
 
-#include <numeric>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
 #include "graph.hpp"
 
 /*
- *  Implementation of the algorithm described in:
- *  Optimal node ranking of trees
- *  Ananth V. Iyer, H. Donald Ratliff, G. Vijayan
- *  https://doi.org/10.1016/0020-0190(88)90194-9
- *
- *  Runtime should be O(n log(n))
- *
- *  Possible changes/improvements:
- *  - Use a 'local' list to remember ranks, instead of having a field inside a vertex.
- *  - Do some bookkeeping to remember the node with highest rank. 
- *  - Are the right datastructures used, especially for L? 
- *  - Generate the critical rank lists L on the fly?
- *
- *  - Use the linear time algorithm as described in
- *    Optimal node ranking of trees in linear time
- *    Alejandro A. Schaffer
- *    https://doi.org/10.1016/0020-0190(89)90161-0
+ *  Implementation of the linear time algorithm described in:
+ *  Optimal node ranking of trees in linear time
+ *  Alejandro A. Schaffer
+ *  https://doi.org/10.1016/0020-0190(89)90161-0
  *
+ *  The critical rank list of a subtree, the ranks that are visible from its
+ *  root (not hidden below a higher rank on the way up), is stored as a bitmask.
+ *  A tree on N vertices has treedepth at most log_2(N) + 1, so 64 bits always
+ *  suffice. The vertices are processed in reverse BFS order, so that all
+ *  children come before their parent, without recursion.
  *
+ *  Runtime is O(N).
  */
 
-
-void root_rank(const Graph &G, int v, int v_prev, std::vector<std::set<int>> &L, int d,
-    std::vector<int> &rank) {
-  int a = 0;
-  // a will contain the maximum over all elements of the L of neighbors of v
-  for (auto vi : G.Adj(v)) {
-    if (vi != v_prev and !L[vi].empty()) {
-      a = std::max(a, *L[vi].rbegin());
-    }
-  }
-  int c = a + 1;
-  int avail = a + 1;
-  L[v] = std::set<int>();
-
-  while (rank[v] == -1) {
-    c--;
-
-    int i = -1;
-    // check in how many lists the max element is equal to c, if only one
-    // remember it in i, if more than 1 set i to -2
-    for (auto vi : G.Adj(v)) {
-      if(vi == v_prev) continue;
-      int ti = L[vi].empty() ? 0 : (*L[vi].rbegin());
-      if (ti == c) {
-        if (i != -1) {
-          i = -2;
-        } else {
-          i = vi;
-        }
+// Returns an optimal ranking of the tree G (ranks start at 0): two vertices
+// with the same rank always have a vertex of higher rank on the path between
+// them. The treedepth is the maximal rank + 1.
+std::vector<int> tree_ranking(const Graph &G) {
+  const int N = G.N;
+  std::vector<int> order, parent(N, -1);
+  order.reserve(N);
+  order.push_back(0);
+  for (int i = 0; i < order.size(); i++) {
+    int v = order[i];
+    for (int w : G.Adj(v))
+      if (w != parent[v]) {
+        parent[w] = v;
+        order.push_back(w);
       }
-    }
-
-    if (i == -2 or (c == 0 and d == 1)) {
-      // if there are two subtrees with critical rank c, then v needs to get a higher rank
-      rank[v] = avail;
-
-      auto it = L[v].lower_bound(avail);
-      L[v].erase(L[v].begin(), it);
-      L[v].insert(avail);
-    } else if (i > -1) {
-      // if there is only one subtree with the current value of c, we can go lower
-      L[v].insert(c);
-      L[i].erase(c);
-    } else if (i == -1) {
-      // No subtree has a rank of c, we can lower the possible rank we're going to assign
-      avail = c;
-    }
   }
-}
+  assert(order.size() == N);
 
-void critical_rank_tree(const Graph &G, int v, int v_prev, 
-    std::vector<std::set<int>> &L, std::vector<int> &rank) {
+  // For every vertex, the union of the critical rank lists of its children,
+  // and the ranks that occur in at least two of them.
+  std::vector<uint64_t> seen(N, 0), twice(N, 0);
+  std::vector<int> rank(N);
+  for (int i = N - 1; i >= 0; i--) {
+    int v = order[i];
 
-  // if you are a leaf node and we're not the first node we're visiting
-  if (G.Adj(v).size() == 1 and v != v_prev) {
-    rank[v] = 1;
-    L[v] = {1};
-  } else {
-    int d = 0;
-    for (auto vi : G.Adj(v)) {
-      // for every subtree starting at a neighbor of v, compute the ranking + critical rank list
-      if (vi != v_prev) {
-        d++;
-        critical_rank_tree(G, vi, v, L, rank);
-      }
+    // The rank of v must exceed every rank that is visible from two of its
+    // children, and not be visible from any of them.
+    int min_rank = twice[v] ? 64 - __builtin_clzll(twice[v]) : 0;
+    uint64_t available = ~seen[v] & (~uint64_t(0) << min_rank);
+    assert(available);
+    rank[v] = __builtin_ctzll(available);
+
+    // The rank of v hides all lower ranks.
+    uint64_t critical =
+        (seen[v] & (~uint64_t(0) << rank[v])) | (uint64_t(1) << rank[v]);
+    if (parent[v] != -1) {
+      twice[parent[v]] |= seen[parent[v]] & critical;
+      seen[parent[v]] |= critical;
     }
-    root_rank(G, v, v_prev, L, d, rank);
   }
+  return rank;
 }
 
+// Returns the treedepth of the tree G and a root attaining it.
 std::pair<int, int> treedepth_tree(const Graph &G) {
-  // Create vector of ranks, that we will pass around.
-  int N = G.N;
-  std::vector<int> rank(N, -1);
-
-  // Create list for every vertex
-  auto L = std::vector<std::set<int>>(N, std::set<int>());
-
-  // Start from vertex 0, can start from any vertex
-  critical_rank_tree(G, 0, 0, L, rank);
-
-  // Find the root with the max rank
-  int maxr = 0, root = -1;
-  for (int v = 0; v < N; v++) {
-    if (rank[v] > maxr) {
-      maxr = rank[v];
-      root = G.global[v];
-    }
-  }
-  assert(root > -1);
-  return {maxr, root};
+  auto rank = tree_ranking(G);
+  int root = 0;
+  for (int v = 1; v < G.N; v++)
+    if (rank[v] > rank[root]) root = v;
+  return {rank[root] + 1, G.global[root]};
 }
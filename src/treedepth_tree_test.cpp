@@ -0,0 +1,99 @@
+#include "treedepth_tree.hpp"
+
+// The checks must run in the release build as well.
+#undef NDEBUG
+#include <cassert>
+#include <chrono>
+#include <fstream>
+#include <random>
+#include <sstream>
+
+#include "treedepth.hpp"
+
+// Checks that in every component of the vertices of rank <= r, there is at
+// most one vertex of rank r.
+bool IsValidRanking(const Graph &G, const std::vector<int> &rank) {
+  int max_rank = *std::max_element(rank.begin(), rank.end());
+  for (int r = 0; r <= max_rank; r++) {
+    std::vector<bool> visited(G.N, false);
+    for (int s = 0; s < G.N; s++) {
+      if (visited[s] || rank[s] > r) continue;
+      int count = 0;
+      std::vector<int> stack{s};
+      visited[s] = true;
+      while (!stack.empty()) {
+        int v = stack.back();
+        stack.pop_back();
+        if (rank[v] == r) count++;
+        for (int w : G.Adj(v))
+          if (!visited[w] && rank[w] <= r) {
+            visited[w] = true;
+            stack.push_back(w);
+          }
+      }
+      if (count > 1) return false;
+    }
+  }
+  return true;
+}
+
+void LoadTree(const std::vector<int> &parent) {
+  std::stringstream stream;
+  stream << "p tdp " << parent.size() << " " << parent.size() - 1;
+  for (int v = 1; v < parent.size(); v++)
+    stream << " " << parent[v] + 1 << " " << v + 1;
+  LoadGraph(stream);
+}
+
+int main() {
+  // Paths have treedepth floor(log_2(N)) + 1.
+  for (int N : {2, 3, 4, 7, 8, 100, 1023, 1024, 200'000}) {
+    std::vector<int> parent(N);
+    for (int v = 1; v < N; v++) parent[v] = v - 1;
+    LoadTree(parent);
+    int td = 1;
+    while (N >>= 1) td++;
+    assert(treedepth_tree(full_graph).first == td);
+    assert(IsValidRanking(full_graph, tree_ranking(full_graph)));
+  }
+
+  // Compare to the brute force on small random trees.
+  std::mt19937 rng(42);
+  for (int N = 2; N <= 9; N++)
+    for (int i = 0; i < 50; i++) {
+      std::vector<int> parent(N);
+      for (int v = 1; v < N; v++) parent[v] = rng() % v;
+      LoadTree(parent);
+      assert(treedepth_tree(full_graph).first ==
+             treedepth_trivial(full_graph));
+      assert(IsValidRanking(full_graph, tree_ranking(full_graph)));
+    }
+
+  // Time the trees of input/test.
+  std::string root = "../input/test/";
+  std::vector<std::pair<std::string, int>> truth_values{
+      {"3_path.gr", 2},           {"5_path.gr", 3},
+      {"7_path.gr", 3},           {"10_path.gr", 4},
+      {"11_path.gr", 4},          {"10_star.gr", 2},
+      {"20_random_tree.gr", -1},  {"30_random_tree.gr", -1},
+      {"40_random_tree.gr", -1},  {"50_random_tree.gr", -1},
+      {"60_random_tree.gr", -1},  {"70_random_tree.gr", -1},
+      {"80_random_tree.gr", -1},  {"90_random_tree.gr", -1},
+      {"100_random_tree.gr", -1}, {"1000_random_tree.gr", -1}};
+  for (auto [fn, true_depth] : truth_values) {
+    std::ifstream input(root + fn, std::ios::in);
+    LoadGraph(input);
+    const int repeat = 1000;
+    auto start = std::chrono::steady_clock::now();
+    int td = 0;
+    for (int i = 0; i < repeat; i++) td = treedepth_tree(full_graph).first;
+    double time = std::chrono::duration<double>(
+                      std::chrono::steady_clock::now() - start)
+                      .count();
+    assert(true_depth == -1 || td == true_depth);
+    assert(IsValidRanking(full_graph, tree_ranking(full_graph)));
+    std::cout << fn << " has treedepth " << td << ", which took "
+              << 1e6 * time / repeat << " microseconds." << std::endl;
+  }
+  return 0;
+}
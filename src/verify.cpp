@@ -1,9 +1,12 @@
 #include <algorithm>
-#include <cassert>
+#include <cstdint>
+#include <cstring>
 #include <vector>
 #include <iostream>
 #include <fstream>
-#include <stack>
+#include <sstream>
+#include <string>
+#include <thread>
 
 
 struct Tree {
@@ -22,95 +25,134 @@ struct Graph {
 /////////////////// CHECK IF TREE IS INDEED TREE /////
 
 
-// Returns false if the graph contains a cycle, else true.
-bool is_tree(Tree const & t) {
-    auto n = t.parent.size();
-    std::vector<int> visited(n, 0);
-
-    for (int u = 1; u < n; u++) {
-        if (visited[u] == 0) {
-            visited[u] = u;
-            auto v = t.parent[u];
-            while(v != 0) {
-                if (visited[v] == u) {
-                    return false;
-                }
-                if(visited[v] > 0) {
-                    break;
-                }
-                visited[v] = u;
-                v = t.parent[v];
-            }
-        }
+// Entry and exit times of a depth first search through the tree, from the
+// virtual root 0. Then u is an ancestor of v iff entry[u] <= entry[v] and
+// exit[v] <= exit[u], so every ancestor query takes O(1).
+struct EulerTour {
+    std::vector<int> entry, exit;
+    bool is_tree = true;  // False if the tree has cycles.
+    int depth = 0;
+
+    bool is_ancestor(int u, int v) const {
+        return entry[u] <= entry[v] && exit[v] <= exit[u];
     }
+};
 
-    return true;
-}
 
+// Takes O(n), assumes that all parents are in range.
+EulerTour euler_tour(Tree const & t) {
+    int n = t.parent.size() - 1;
 
-// helper function for treedepth
-int _tree_depth(Tree const & t, std::vector<int> & depth, int vertex) {
-    std::stack<int> d({vertex});
-    while (depth[d.top()] == -1 && d.top() != 0) {
-        d.push(t.parent[d.top()]);
+    // The children of every vertex, in compressed form.
+    std::vector<int> first(n + 2, 0), child(n);
+    for (int u = 1; u <= n; u++) {
+        first[t.parent[u] + 1]++;
+    }
+    for (int u = 0; u <= n; u++) {
+        first[u + 1] += first[u];
+    }
+    std::vector<int> next(first.begin(), first.end() - 1);
+    for (int u = 1; u <= n; u++) {
+        child[next[t.parent[u]]++] = u;
     }
 
-    auto curr= depth[d.top()];
-    d.pop();
-    while(!d.empty()) {
-        depth[d.top()] = ++curr;
-        d.pop();
+    EulerTour tour;
+    tour.entry.assign(n + 1, -1);
+    tour.exit.assign(n + 1, -1);
+    std::vector<int> depth(n + 1, 0), stack({0});
+    std::copy(first.begin(), first.end() - 1, next.begin());
+    int time = 0, visited = 0;
+    tour.entry[0] = time++;
+    while (!stack.empty()) {
+        int u = stack.back();
+        if (next[u] < first[u + 1]) {
+            int v = child[next[u]++];
+            tour.entry[v] = time++;
+            depth[v] = depth[u] + 1;
+            tour.depth = std::max(tour.depth, depth[v]);
+            visited++;
+            stack.push_back(v);
+        } else {
+            tour.exit[u] = time++;
+            stack.pop_back();
+        }
     }
-    return curr;
+
+    // Vertices on a cycle are not reachable from the roots.
+    tour.is_tree = visited == n;
+    return tour;
 }
 
 
-int tree_depth(Tree const & t) {
-    std::vector<int> depth(t.parent.size(), -1);
+// Returns false if the graph contains a cycle, else true.
+bool is_tree(Tree const & t) {
+    return euler_tour(t).is_tree;
+}
 
-    int max = 0;
-    for (int u = 1; u < t.parent.size(); u++) {
-        max = std::max(max, _tree_depth(t, depth, u));
-    }
 
-    return max + 1;
+int tree_depth(Tree const & t) {
+    return euler_tour(t).depth;
 }
 
 
 
 ///////////////////// VERIFY //////////////////////
 
-bool verify_edge(Edge const & e, Tree const & tree) {
-    auto start = e.second;
-    while (start != 0) {
-        if (start == e.first) {
-            return true;
-        }
-        start = tree.parent[start];
-    }
-    return false;
-}
-
-
 bool verify(Graph const & g, Tree const & t) {
     if (t.parent.size()-1 != g.n) {
         std::cerr << "Tree has incorrect nr of nodes! tree size= " << t.parent.size() - 1 << " vs. graph size = " << g.n  << "\n";
         return false;
     }
 
-    if (!is_tree(t)) {
+    for (std::size_t u = 1; u <= g.n; u++) {
+        if (t.parent[u] < 0 || t.parent[u] > g.n) {
+            std::cerr << "Tree has invalid parent " << t.parent[u] << " of " << u << "\n";
+            return false;
+        }
+    }
+
+    auto tour = euler_tour(t);
+    if (!tour.is_tree) {
         std::cerr << "Tree has cycles!\n";
         return false;
     }
-    for(auto const & e:g.edges) {
-        if (!(verify_edge(e, t) || verify_edge(Edge(e.second, e.first), t))) {
-            std::cerr << "Error, edge " << e.first << " " << e.second  << "\n";
-            return false;
+
+    // Check the edges in parallel, each thread finds the first bad edge in its
+    // part of them.
+    auto first_bad_edge = [&](std::size_t from, std::size_t to) {
+        for (auto i = from; i < to; i++) {
+            auto e = g.edges[i];
+            if (e.first < 1 || e.second < 1 || e.first > g.n || e.second > g.n ||
+                !(tour.is_ancestor(e.first, e.second) || tour.is_ancestor(e.second, e.first))) {
+                return i;
+            }
         }
+        return g.edges.size();
+    };
+    std::size_t m = g.edges.size(), threads = 1;
+    if (m >= (1 << 16)) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    std::vector<std::size_t> bad(threads, m);
+    std::vector<std::thread> workers;
+    for (std::size_t i = 1; i < threads; i++) {
+        workers.emplace_back([&, i]() {
+            bad[i] = first_bad_edge(m * i / threads, m * (i + 1) / threads);
+        });
+    }
+    bad[0] = first_bad_edge(0, m / threads);
+    for (auto & worker : workers) {
+        worker.join();
+    }
+    auto bad_edge = *std::min_element(bad.begin(), bad.end());
+    if (bad_edge < m) {
+        auto e = g.edges[bad_edge];
+        std::cerr << "Error, edge " << e.first << " " << e.second  << "\n";
+        return false;
     }
 
-    if (tree_depth(t) != t.depth) {
-        std::cerr << "Tree has incorrect tree depth! Real " << tree_depth(t)  << " vs. declared" << t.depth  << "\n";
+    if (tour.depth != t.depth) {
+        std::cerr << "Tree has incorrect tree depth! Real " << tour.depth  << " vs. declared" << t.depth  << "\n";
         return false;
     }
 
@@ -157,17 +199,99 @@ bool test_cycle_big() {
     return !verify(g, tree);
 }
 
-void run_tests() {
-    std::cout << "Testing (2 cycle errors expected)" << std::endl;
-    assert(test_accept());
-    assert(test_incorrect());
-    assert(test_cycle());
-    assert(test_cycle_big());
+Graph read_binary_graph(std::istream & stream);
+
+
+// A graph in the uncompressed binary format, with the given adjacency lists.
+std::string binary_graph(std::vector<std::vector<std::uint32_t>> const & adj) {
+    std::string data = "tdULLcsr";
+    auto store = [&](std::uint64_t value, int bytes) {
+        for (int i = 0; i < bytes; i++) {
+            data.push_back(char(value >> (8 * i)));
+        }
+    };
+    std::size_t size = 0;
+    for (auto & neighbours : adj) {
+        size += neighbours.size();
+    }
+    store(0, 4);
+    store(adj.size(), 4);
+    store(size, 8);
+    std::size_t offset = 0;
+    store(offset, 8);
+    for (auto & neighbours : adj) {
+        store(offset += neighbours.size(), 8);
+    }
+    for (auto & neighbours : adj) {
+        for (auto w : neighbours) {
+            store(w, 4);
+        }
+    }
+    return data;
+}
+
+
+bool test_binary_graph() {
+    auto read = [](std::string const & data) {
+        std::istringstream stream(data);
+        return read_binary_graph(stream);
+    };
+    auto g = read(binary_graph({{1, 2}, {0}, {0}}));
+    return g.n == 3 && g.edges == std::vector<Edge>{{1, 2}, {1, 3}} &&
+           read(binary_graph({{1}, {}})).n == 0 &&          // Asymmetric.
+           read(binary_graph({{0}})).n == 0 &&              // Self-loop.
+           read(binary_graph({{1, 1}, {0, 0}})).n == 0 &&   // Duplicate.
+           read(binary_graph({{0xffffffff}, {}})).n == 0;   // Out of range.
+}
+
+// Returns whether all tests pass. The checks do not use assert, which the
+// release build compiles away.
+bool run_tests() {
+    std::cout << "Testing (2 cycle errors and 4 graph errors expected)" << std::endl;
+    std::pair<const char *, bool (*)()> tests[] = {
+        {"test_accept", test_accept},
+        {"test_incorrect", test_incorrect},
+        {"test_cycle", test_cycle},
+        {"test_cycle_big", test_cycle_big},
+        {"test_binary_graph", test_binary_graph},
+    };
+    bool passed = true;
+    for (auto & [name, test] : tests) {
+        if (!test()) {
+            std::cout << name << " FAILED" << std::endl;
+            passed = false;
+        }
+    }
+    return passed;
 }
 
 
 ////////////////////////////////// READ DATA /////////////////////////
 
+// Reads all that is left in the stream.
+std::string read_all(std::istream & stream) {
+    std::ostringstream data;
+    data << stream.rdbuf();
+    return data.str();
+}
+
+
+// Parses the number at p, which should be followed by `next`, or by the end of
+// the line if next is 0. Returns false if it is malformed.
+bool parse_number(const char * & p, const char * end, char next, std::size_t & value) {
+    const char * start = p;
+    value = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+        value = 10 * value + (*p++ - '0');
+    }
+    if (p == start) {
+        return false;
+    }
+    return next ? p < end && *p++ == next : p == end;
+}
+
+
+// Reads the whole graph in one go, and parses it line by line by hand.
 Graph read_graph(std::istream & stream) {
     //std::size_t vertex_count = 0;
     std::size_t edge_count = 0;
@@ -178,62 +302,43 @@ Graph read_graph(std::istream & stream) {
     Graph g;
 
     if (stream.good()) {
-        std::string line;
-        std::size_t pos = 0;
+        auto data = read_all(stream);
+        const char * p = data.data(), * data_end = p + data.size();
+
+        while (!error && p < data_end) {
+            auto end = static_cast<const char *>(std::memchr(p, '\n', data_end - p));
+            auto next_line = end ? end + 1 : data_end;
+            if (!end) {
+                end = data_end;
+            }
+            if (end > p && end[-1] == '\r') {
+                end--;
+            }
 
-        while (!error && std::getline(stream, line)) {
-            if (line.empty()) {
+            if (end == p) {
                 error = true;
-            } else {
-                if (line.back() == '\r') {
-                    line.pop_back();
-                }
-
-                if (line[0] != 'c') {
-                    if (firstLine) {
-                        auto head = std::string("p tdp ");
-                        if (line.compare(0, head.size(), head) != 0) {
-                            error = true;
-                        }
-
-                        line = line.substr(head.size());
-
-                        g.n = std::stol(line, &pos);
-
-                        if (line[pos] != ' ') {
-                            error = true;
-                        }
-
-                        line = line.substr(pos + 1);
-
-                        edge_count = std::stol(line, &pos);
-
-                        if (pos != line.length()) {
-                            error = true;
-                        }
-
-                        firstLine = false;
+            } else if (*p != 'c') {
+                if (firstLine) {
+                    auto head = std::string("p tdp ");
+                    if (std::size_t(end - p) < head.size() || head.compare(0, head.size(), p, head.size()) != 0) {
+                        error = true;
                     } else {
-                        auto vertex1 = std::stoul(line, &pos);
-
-                        if (line[pos] != ' ') {
-                            error = true;
-                        } else {
-                            line = line.substr(pos + 1);
-
-                            auto vertex2 = std::stoul(line, &pos);
-
-                            if (pos != line.length()) {
-                                error = true;
-                            }
-
-                            g.edges.push_back(Edge(vertex1, vertex2));
-
-                            edge_count--;
-                        }
+                        p += head.size();
+                        error = !parse_number(p, end, ' ', g.n) || !parse_number(p, end, 0, edge_count);
+                    }
+                    g.edges.reserve(edge_count);
+                    firstLine = false;
+                } else {
+                    std::size_t vertex1, vertex2;
+                    if (edge_count == 0 || !parse_number(p, end, ' ', vertex1) || !parse_number(p, end, 0, vertex2)) {
+                        error = true;
+                    } else {
+                        g.edges.push_back(Edge(vertex1, vertex2));
+                        edge_count--;
                     }
                 }
             }
+            p = next_line;
         }
 
         if (edge_count != 0) {
@@ -252,25 +357,129 @@ Graph read_graph(std::istream & stream) {
 }
 
 
+// Reads a graph in the binary format of graph_io.hpp, kept independent of it.
+Graph read_binary_graph(std::istream & stream) {
+    auto data = read_all(stream);
+    auto load = [&](std::size_t pos, std::size_t bytes) {
+        std::uint64_t value = 0;
+        for (std::size_t i = 0; i < bytes; i++) {
+            value |= std::uint64_t(std::uint8_t(data[pos + i])) << (8 * i);
+        }
+        return value;
+    };
+
+    Graph g;
+    if (data.size() < 24) {
+        std::cerr << "Error while parsing graph instance\n";
+        return {};
+    }
+    auto flags = load(8, 4);
+    g.n = load(12, 4);
+    auto size = load(16, 8);
+    std::size_t offsets = 24, neighbours = offsets + 8 * (g.n + 1);
+    if (data.size() < neighbours || flags > 1 ||
+        (data.size() - neighbours) / (flags ? 1 : 4) < size) {
+        std::cerr << "Error while parsing graph instance\n";
+        return {};
+    }
+
+    // Both directions of an edge must be stored: g.edges gets the ones with
+    // v < w, and reverse the others, which must be the same edges.
+    std::vector<Edge> reverse;
+    bool error = load(offsets, 8) != 0 || load(offsets + 8 * g.n, 8) != size;
+    for (std::size_t v = 0; v < g.n && !error; v++) {
+        auto from = load(offsets + 8 * v, 8), to = load(offsets + 8 * v + 8, 8);
+        error = to < from || to > size;
+        std::int64_t w = v;
+        for (auto i = from; i < to && !error;) {
+            if (flags) {
+                std::uint64_t zigzag = 0;
+                for (int shift = 0;; shift += 7) {
+                    if (i == to || shift > 63) {
+                        error = true;
+                        break;
+                    }
+                    zigzag |= std::uint64_t(data[neighbours + i] & 127) << shift;
+                    if (!(data[neighbours + i++] & 128)) break;
+                }
+                w += std::int64_t(zigzag >> 1) ^ -std::int64_t(zigzag & 1);
+            } else {
+                w = load(neighbours + 4 * i++, 4);
+            }
+            if (w < 0 || std::size_t(w) >= g.n || std::size_t(w) == v) {
+                error = true;
+            } else if (std::size_t(w) > v) {
+                g.edges.push_back(Edge(v + 1, w + 1));
+            } else {
+                reverse.push_back(Edge(w + 1, v + 1));
+            }
+        }
+    }
+    std::sort(g.edges.begin(), g.edges.end());
+    std::sort(reverse.begin(), reverse.end());
+    if (error || g.edges != reverse ||
+        std::adjacent_find(g.edges.begin(), g.edges.end()) != g.edges.end()) {
+        std::cerr << "Error while parsing graph instance\n";
+        return {};
+    }
+    return g;
+}
+
+
+// Reads the tree in one go, and parses the numbers by hand. Also accepts the
+// binary format of graph_io.hpp, starting with "tdULLtre".
 Tree read_tree(std::istream & stream) {
+    auto data = read_all(stream);
     bool error = false;
     //-1 in the beginning since vertices starts with 1
     Tree t = {{-1}, -1};
 
-
-    if (stream.good()) {
-        std::string line;
-        // std::size_t pos = 0;
-        if( !std::getline(stream, line)) {
-            error = true;
+    if (data.compare(0, 8, "tdULLtre") == 0 && data.size() >= 16) {
+        auto load = [&](std::size_t pos) {
+            std::uint32_t value = 0;
+            for (std::size_t i = 0; i < 4; i++) {
+                value |= std::uint32_t(std::uint8_t(data[pos + i])) << (8 * i);
+            }
+            return value;
+        };
+        std::size_t n = load(8);
+        t.depth = load(12);
+        error = data.size() != 16 + 4 * n;
+        for (std::size_t v = 0; !error && v < n; v++) {
+            t.parent.push_back(load(16 + 4 * v));
         }
-        t.depth = std::stol(line);
-
-        while (!error && std::getline(stream, line)) {
-            if (line.empty()) {
+    } else {
+        // One number per line, the depth and then the parents.
+        const char * p = data.data(), * end = p + data.size();
+        bool first = true;
+        while (!error && p < end) {
+            bool negative = *p == '-';
+            if (negative) {
+                p++;
+            }
+            long value = 0;
+            const char * start = p;
+            while (p < end && *p >= '0' && *p <= '9') {
+                value = 10 * value + (*p++ - '0');
+            }
+            if (p < end && *p == '\r') {
+                p++;
+            }
+            if (p == start || (p < end && *p++ != '\n')) {
                 error = true;
             }
-            t.parent.push_back(std::stol(line));
+            if (negative) {
+                value = -value;
+            }
+            if (first) {
+                t.depth = value;
+                first = false;
+            } else {
+                t.parent.push_back(value);
+            }
+        }
+        if (first) {
+            error = true;
         }
     }
 
@@ -284,19 +493,26 @@ Tree read_tree(std::istream & stream) {
 
 
 int main(int argc, char* argv[]) {
-    //run_tests();
-
+    if (argc == 2 && std::string(argv[1]) == "--test") {
+        return run_tests() ? 0 : 1;
+    }
 
     if (argc < 3) {
         std::cerr << "usage: " << argv[0] << " graph_file.gr tree_depth_decomposition_file.tree\n";
         return -1;
     }
 
-    std::ifstream if_graph (argv[1], std::ifstream::in);
-    std::ifstream if_tree (argv[2], std::ifstream::in);
+    std::ifstream if_graph (argv[1], std::ifstream::in | std::ifstream::binary);
+    std::ifstream if_tree (argv[2], std::ifstream::in | std::ifstream::binary);
 
 
-    auto g = read_graph(if_graph);
+    // Graphs in the binary format start with "tdULLcsr".
+    std::string magic(8, ' ');
+    if_graph.read(&magic[0], 8);
+    if_graph.clear();
+    if_graph.seekg(0);
+    auto g = magic == "tdULLcsr" ? read_binary_graph(if_graph)
+                                 : read_graph(if_graph);
     auto t = read_tree(if_tree);
     if (verify(g,t)) {
         std::cout << t.depth << "|SUCCEED" << std::endl;